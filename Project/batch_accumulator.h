@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Relevance scores of a batch of queries over a window of document ordinals. The scores of
+// all queries for one ordinal are adjacent, so a posting shared by several queries of the
+// batch updates a single cache line. Like RelevanceAccumulator, every query remembers its
+// touched offsets, so clearing costs O(touched)
+class BatchAccumulator {
+public:
+
+    // Prepares the accumulator for query_count queries and offsets in [0, window_size) and drops previous scores
+    void Reset(size_t query_count, size_t window_size) {
+        Clear();
+        query_count_ = query_count;
+        if (scores_.size() < query_count * window_size) {
+            scores_.resize(query_count * window_size, 0.0);
+            states_.resize(query_count * window_size, State::UNTOUCHED);
+        }
+        if (touched_.size() < query_count) {
+            touched_.resize(query_count);
+        }
+    }
+
+    void Add(size_t query, int offset, double relevance) {
+        const size_t index = offset * query_count_ + query;
+        switch (states_[index]) {
+        case State::UNTOUCHED:
+            states_[index] = State::SCORED;
+            touched_[query].push_back(offset);
+            scores_[index] = relevance;
+            break;
+        case State::SCORED:
+            scores_[index] += relevance;
+            break;
+        case State::EXCLUDED:
+            break;
+        }
+    }
+
+    // Drops the score of the query at the offset and ignores further additions to it
+    void Exclude(size_t query, int offset) {
+        const size_t index = offset * query_count_ + query;
+        if (states_[index] == State::UNTOUCHED) {
+            touched_[query].push_back(offset);
+        }
+        states_[index] = State::EXCLUDED;
+    }
+
+    // Calls function(offset, relevance) for every scored and not excluded offset of the query
+    template <typename Function>
+    void ForEach(size_t query, Function function) const {
+        for (const int offset : touched_[query]) {
+            const size_t index = offset * query_count_ + query;
+            if (states_[index] == State::SCORED) {
+                function(offset, scores_[index]);
+            }
+        }
+    }
+
+    void Clear() {
+        for (size_t query = 0; query < query_count_; ++query) {
+            for (const int offset : touched_[query]) {
+                states_[offset * query_count_ + query] = State::UNTOUCHED;
+            }
+            touched_[query].clear();
+        }
+    }
+
+    // Instance owned by the calling thread; its buffers are reused across batches
+    static BatchAccumulator& ForThisThread() {
+        static thread_local BatchAccumulator accumulator;
+        return accumulator;
+    }
+
+private:
+    enum class State : uint8_t {
+        UNTOUCHED,
+        SCORED,
+        EXCLUDED,
+    };
+
+    size_t query_count_ = 0;
+    std::vector<double> scores_;
+    std::vector<State> states_;
+    std::vector<std::vector<int>> touched_;
+};
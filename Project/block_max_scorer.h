@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "posting_list.h"
+#include "top_documents.h"
+
+// Top documents of a query by block-max MaxScore. The ordinal range is scored in windows of
+// WINDOW_SIZE ordinals; the block upper bounds of every term give the best score a document of
+// the window can reach. Windows that cannot beat the current worst top document are skipped.
+// In the others, the terms with the smallest bounds that together cannot beat it are
+// non-essential: documents are found through the essential terms only, then the non-essential
+// terms are added from the largest bound down, dropping every document whose score and the bounds
+// of the terms left cannot beat it. The remaining documents are scored again in the order of
+// the terms, so relevances are bitwise those of exhaustive scoring
+class BlockMaxScorer {
+public:
+    using Terms = std::vector<std::pair<const PostingList*, double>>;
+
+    // Pushes to top_documents make_document(ordinal, relevance) for the documents in [first_ordinal, last_ordinal)
+    // that may enter the top and pass is_allowed(ordinal). Frozen lists are scored with their precomputed scores
+    template <typename Filter, typename MakeDocument>
+    void Score(const Terms& terms, bool use_frozen_scores, int first_ordinal, int last_ordinal,
+        Filter is_allowed, MakeDocument make_document, TopDocuments& top_documents) {
+        if (top_documents.GetMaxCount() == 0) {
+            return;
+        }
+        const size_t term_count = terms.size();
+        positions_.resize(term_count);
+        ends_.resize(term_count);
+        bounds_.resize(term_count);
+        order_.resize(term_count);
+        states_.resize(WINDOW_SIZE, State::UNSEEN);
+        scores_.resize(WINDOW_SIZE, 0.0);
+        for (size_t i = 0; i < term_count; ++i) {
+            positions_[i] = terms[i].first->Seek(0, first_ordinal);
+        }
+
+        const auto get_contribution = [&terms, use_frozen_scores](size_t i, size_t position) {
+            const auto& [postings, inverse_document_freq] = terms[i];
+            return use_frozen_scores ? postings->GetScore(position) : postings->GetTermFreq(position) * inverse_document_freq;
+        };
+        // Adds the contributions of term i to the candidates, walking whichever of the two is shorter
+        const auto add_term = [&](size_t i, int window_begin) {
+            const PostingList& postings = *terms[i].first;
+            if (ends_[i] - positions_[i] < candidates_.size()) {
+                for (size_t position = positions_[i]; position < ends_[i]; ++position) {
+                    const int offset = postings.GetOrdinal(position) - window_begin;
+                    if (states_[offset] == State::CANDIDATE && !postings.IsErased(position)) {
+                        scores_[offset] += get_contribution(i, position);
+                    }
+                }
+                return;
+            }
+            size_t position = positions_[i];
+            for (const int offset : candidates_) {
+                position = postings.Seek(position, window_begin + offset);
+                if (position == ends_[i]) {
+                    break;
+                }
+                if (postings.GetOrdinal(position) == window_begin + offset && !postings.IsErased(position)) {
+                    scores_[offset] += get_contribution(i, position);
+                }
+            }
+        };
+
+        for (int window_begin = first_ordinal; window_begin < last_ordinal; window_begin += WINDOW_SIZE) {
+            const int window_end = std::min(last_ordinal, window_begin + WINDOW_SIZE);
+            double bound_sum = 0.0;
+            for (size_t i = 0; i < term_count; ++i) {
+                const PostingList& postings = *terms[i].first;
+                ends_[i] = postings.Seek(positions_[i], window_end);
+                bounds_[i] = positions_[i] < ends_[i] ? postings.GetMaxTermFreq(positions_[i], ends_[i]) * terms[i].second : 0.0;
+                bound_sum += bounds_[i];
+            }
+
+            const double threshold = GetThreshold(top_documents);
+            if (bound_sum < threshold) {
+                positions_.swap(ends_);
+                continue;
+            }
+
+            // Terms by increasing bound; the first essential_begin of them are non-essential
+            std::iota(order_.begin(), order_.end(), size_t{ 0 });
+            std::sort(order_.begin(), order_.end(), [this](size_t lhs, size_t rhs) {
+                return bounds_[lhs] < bounds_[rhs];
+                });
+            size_t essential_begin = 0;
+            double non_essential_bound = 0.0;
+            while (essential_begin < term_count && non_essential_bound + bounds_[order_[essential_begin]] < threshold) {
+                non_essential_bound += bounds_[order_[essential_begin++]];
+            }
+            // When the non-essential terms hold few of the postings, probing them costs more than it saves
+            size_t posting_count = 0;
+            size_t non_essential_posting_count = 0;
+            for (size_t k = 0; k < term_count; ++k) {
+                const size_t count = ends_[order_[k]] - positions_[order_[k]];
+                posting_count += count;
+                non_essential_posting_count += k < essential_begin ? count : 0;
+            }
+            if (non_essential_posting_count * MIN_SKIPPED_POSTING_SHARE < posting_count) {
+                essential_begin = 0;
+                non_essential_bound = 0.0;
+            }
+            // Summed in term order, the scores over the essential terms are exact when every term is essential
+            std::sort(order_.begin() + essential_begin, order_.end());
+
+            for (size_t k = essential_begin; k < term_count; ++k) {
+                const size_t i = order_[k];
+                const PostingList& postings = *terms[i].first;
+                for (size_t position = positions_[i]; position < ends_[i]; ++position) {
+                    if (postings.IsErased(position)) {
+                        continue;
+                    }
+                    const int offset = postings.GetOrdinal(position) - window_begin;
+                    if (states_[offset] == State::UNSEEN) {
+                        states_[offset] = State::CANDIDATE;
+                        candidates_.push_back(offset);
+                    }
+                    scores_[offset] += get_contribution(i, position);
+                }
+            }
+            // The filter runs on the first pass, before any non-essential term is added
+            double remaining_bound = non_essential_bound;
+            size_t next_non_essential = essential_begin;
+            while (true) {
+                size_t kept_count = 0;
+                for (const int offset : candidates_) {
+                    if (scores_[offset] + remaining_bound >= threshold
+                        && (next_non_essential < essential_begin || is_allowed(window_begin + offset))) {
+                        candidates_[kept_count++] = offset;
+                    }
+                    else {
+                        states_[offset] = State::UNSEEN;
+                        scores_[offset] = 0.0;
+                    }
+                }
+                candidates_.resize(kept_count);
+                if (next_non_essential == 0 || candidates_.empty()) {
+                    break;
+                }
+                if (next_non_essential == essential_begin) {
+                    // Few are left after the first pass; probing needs them in order
+                    std::sort(candidates_.begin(), candidates_.end());
+                }
+                const size_t i = order_[--next_non_essential];
+                remaining_bound -= bounds_[i];
+                add_term(i, window_begin);
+            }
+
+            if (essential_begin > 0) {
+                // Every term is probed, so the candidates are ordered even if no non-essential term was added
+                std::sort(candidates_.begin(), candidates_.end());
+                for (const int offset : candidates_) {
+                    scores_[offset] = 0.0;
+                }
+                for (size_t i = 0; i < term_count; ++i) {
+                    add_term(i, window_begin);
+                }
+            }
+
+            for (const int offset : candidates_) {
+                top_documents.Push(make_document(window_begin + offset, scores_[offset]));
+                states_[offset] = State::UNSEEN;
+                scores_[offset] = 0.0;
+            }
+            candidates_.clear();
+            positions_.swap(ends_);
+        }
+    }
+
+    // Instance owned by the calling thread; its buffers are reused across queries
+    static BlockMaxScorer& ForThisThread() {
+        static thread_local BlockMaxScorer scorer;
+        return scorer;
+    }
+
+private:
+    static constexpr int WINDOW_SIZE = 4096;
+    // TopDocuments::IsBetter treats relevances closer than 1e-6 as equal, so a document is
+    // only certain to lose with a margin of that much, plus room for rounding of the bounds
+    static constexpr double PRUNING_MARGIN = 2e-6;
+    // Windows are pruned only if the non-essential terms hold at least this share of the postings (1 / value)
+    static constexpr size_t MIN_SKIPPED_POSTING_SHARE = 2;
+
+    enum class State : uint8_t {
+        UNSEEN,
+        CANDIDATE,
+    };
+
+    std::vector<size_t> positions_;
+    std::vector<size_t> ends_;
+    std::vector<double> bounds_;
+    std::vector<size_t> order_;
+    // Indexed by offset in the window
+    std::vector<State> states_;
+    std::vector<double> scores_;
+    // Offsets in the window of the documents still able to enter the top, ascending
+    std::vector<int> candidates_;
+
+    // Documents scoring below the threshold cannot enter the top
+    static double GetThreshold(const TopDocuments& top_documents) {
+        if (!top_documents.IsFull()) {
+            return -std::numeric_limits<double>::infinity();
+        }
+        return top_documents.GetWorst().relevance - PRUNING_MARGIN;
+    }
+};
@@ -0,0 +1,218 @@
+#include "compressed_postings.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SEARCH_SERVER_HAS_SSE2
+#endif
+
+using namespace std;
+
+namespace {
+
+constexpr size_t LANE_COUNT = 4;
+constexpr size_t LANE_SIZE = CompressedPostings::BLOCK_SIZE / LANE_COUNT;
+
+int GetBitWidth(uint32_t value) {
+    int width = 0;
+    while (value != 0) {
+        ++width;
+        value >>= 1;
+    }
+    return width;
+}
+
+// Gap i goes to lane i % 4 at slot i / 4; every lane packs its slots into width 32-bit words,
+// and word k of lane l is stored at 4 * k + l
+void PackGaps(const uint32_t* gaps, int width, vector<uint8_t>& data) {
+    vector<uint32_t> words(LANE_COUNT * width, 0);
+    for (size_t i = 0; i < CompressedPostings::BLOCK_SIZE; ++i) {
+        const size_t lane = i % LANE_COUNT;
+        const size_t bit = i / LANE_COUNT * width;
+        const uint64_t value = uint64_t{ gaps[i] } << (bit % 32);
+        words[LANE_COUNT * (bit / 32) + lane] |= static_cast<uint32_t>(value);
+        if (bit % 32 + width > 32) {
+            words[LANE_COUNT * (bit / 32 + 1) + lane] |= static_cast<uint32_t>(value >> 32);
+        }
+    }
+    const size_t offset = data.size();
+    data.resize(offset + words.size() * sizeof(uint32_t));
+    memcpy(data.data() + offset, words.data(), words.size() * sizeof(uint32_t));
+}
+
+void UnpackGaps(const uint8_t* packed, int width, uint32_t* gaps) {
+    if (width == 0) {
+        fill(gaps, gaps + CompressedPostings::BLOCK_SIZE, 0);
+        return;
+    }
+#ifdef SEARCH_SERVER_HAS_SSE2
+    const __m128i mask = _mm_set1_epi32(width == 32 ? -1 : static_cast<int>((1u << width) - 1));
+    for (size_t slot = 0; slot < LANE_SIZE; ++slot) {
+        const size_t bit = slot * width;
+        const auto* words = reinterpret_cast<const __m128i*>(packed) + bit / 32;
+        __m128i values = _mm_srl_epi32(_mm_loadu_si128(words), _mm_cvtsi32_si128(bit % 32));
+        if (bit % 32 + width > 32) {
+            values = _mm_or_si128(values, _mm_sll_epi32(_mm_loadu_si128(words + 1), _mm_cvtsi32_si128(32 - bit % 32)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(gaps + LANE_COUNT * slot), _mm_and_si128(values, mask));
+    }
+#else
+    uint32_t words[LANE_COUNT * 32];
+    memcpy(words, packed, LANE_COUNT * width * sizeof(uint32_t));
+    const uint64_t mask = (uint64_t{ 1 } << width) - 1;
+    for (size_t i = 0; i < CompressedPostings::BLOCK_SIZE; ++i) {
+        const size_t lane = i % LANE_COUNT;
+        const size_t bit = i / LANE_COUNT * width;
+        uint64_t value = words[LANE_COUNT * (bit / 32) + lane] >> (bit % 32);
+        if (bit % 32 + width > 32) {
+            value |= uint64_t{ words[LANE_COUNT * (bit / 32 + 1) + lane] } << (32 - bit % 32);
+        }
+        gaps[i] = static_cast<uint32_t>(value & mask);
+    }
+#endif
+}
+
+void WriteVarint(uint32_t value, vector<uint8_t>& data) {
+    while (value >= 0x80) {
+        data.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t ReadVarint(const uint8_t*& data) {
+    uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        const uint8_t byte = *data++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            return value;
+        }
+    }
+}
+
+template <typename Quantized>
+void WriteQuantized(const double* term_freqs, size_t count, double max_term_freq, vector<uint8_t>& data) {
+    constexpr double LEVELS = static_cast<double>(static_cast<Quantized>(-1));
+    for (size_t i = 0; i < count; ++i) {
+        const Quantized level = static_cast<Quantized>(clamp(lround(term_freqs[i] / max_term_freq * LEVELS), 1L, static_cast<long>(LEVELS)));
+        const size_t offset = data.size();
+        data.resize(offset + sizeof(Quantized));
+        memcpy(data.data() + offset, &level, sizeof(Quantized));
+    }
+}
+
+template <typename Quantized>
+void ReadQuantized(const uint8_t* data, size_t count, double max_term_freq, double* term_freqs) {
+    constexpr double LEVELS = static_cast<double>(static_cast<Quantized>(-1));
+    const double step = max_term_freq / LEVELS;
+    for (size_t i = 0; i < count; ++i) {
+        Quantized level;
+        memcpy(&level, data + i * sizeof(Quantized), sizeof(Quantized));
+        term_freqs[i] = level * step;
+    }
+}
+
+} // namespace
+
+CompressedPostings::CompressedPostings(const std::vector<int>& ordinals, const std::vector<double>& term_freqs, TermFreqPrecision precision)
+    : precision_(precision)
+    , count_(ordinals.size()) {
+    uint32_t gaps[BLOCK_SIZE];
+    for (size_t first = 0; first < count_; first += BLOCK_SIZE) {
+        const size_t count = min(BLOCK_SIZE, count_ - first);
+        int previous = block_last_ordinals_.empty() ? -1 : block_last_ordinals_.back();
+        uint32_t max_gap = 0;
+        for (size_t i = 0; i < count; ++i) {
+            // Ordinals are distinct, so every gap is at least 1
+            gaps[i] = static_cast<uint32_t>(ordinals[first + i] - previous - 1);
+            max_gap = max(max_gap, gaps[i]);
+            previous = ordinals[first + i];
+        }
+        block_last_ordinals_.push_back(previous);
+        block_offsets_.push_back(static_cast<uint32_t>(data_.size()));
+
+        if (count == BLOCK_SIZE) {
+            const int width = GetBitWidth(max_gap);
+            data_.push_back(static_cast<uint8_t>(width));
+            PackGaps(gaps, width, data_);
+        }
+        else {
+            for (size_t i = 0; i < count; ++i) {
+                WriteVarint(gaps[i], data_);
+            }
+        }
+
+        const double* block_term_freqs = term_freqs.data() + first;
+        if (precision_ == TermFreqPrecision::FULL) {
+            const size_t offset = data_.size();
+            data_.resize(offset + count * sizeof(double));
+            memcpy(data_.data() + offset, block_term_freqs, count * sizeof(double));
+            continue;
+        }
+        const double max_term_freq = *max_element(block_term_freqs, block_term_freqs + count);
+        block_max_term_freqs_.push_back(max_term_freq);
+        if (precision_ == TermFreqPrecision::BITS_16) {
+            WriteQuantized<uint16_t>(block_term_freqs, count, max_term_freq, data_);
+        }
+        else {
+            WriteQuantized<uint8_t>(block_term_freqs, count, max_term_freq, data_);
+        }
+    }
+    data_.shrink_to_fit();
+}
+
+bool CompressedPostings::Contains(int ordinal) const {
+    const size_t block = lower_bound(block_last_ordinals_.begin(), block_last_ordinals_.end(), ordinal) - block_last_ordinals_.begin();
+    if (block == block_last_ordinals_.size()) {
+        return false;
+    }
+    int ordinals[BLOCK_SIZE];
+    double term_freqs[BLOCK_SIZE];
+    const size_t count = DecodeBlock(block, ordinals, term_freqs);
+    return binary_search(ordinals, ordinals + count, ordinal);
+}
+
+void CompressedPostings::Decode(std::vector<int>& ordinals, std::vector<double>& term_freqs) const {
+    ordinals.resize(count_);
+    term_freqs.resize(count_);
+    for (size_t block = 0; block < block_last_ordinals_.size(); ++block) {
+        DecodeBlock(block, ordinals.data() + block * BLOCK_SIZE, term_freqs.data() + block * BLOCK_SIZE);
+    }
+}
+
+size_t CompressedPostings::DecodeBlock(size_t block, int* ordinals, double* term_freqs) const {
+    const size_t count = min(BLOCK_SIZE, count_ - block * BLOCK_SIZE);
+    const uint8_t* data = data_.data() + block_offsets_[block];
+    uint32_t gaps[BLOCK_SIZE];
+    if (count == BLOCK_SIZE) {
+        const int width = *data++;
+        UnpackGaps(data, width, gaps);
+        data += LANE_COUNT * width * sizeof(uint32_t);
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) {
+            gaps[i] = ReadVarint(data);
+        }
+    }
+    int previous = block == 0 ? -1 : block_last_ordinals_[block - 1];
+    for (size_t i = 0; i < count; ++i) {
+        previous += static_cast<int>(gaps[i]) + 1;
+        ordinals[i] = previous;
+    }
+
+    switch (precision_) {
+    case TermFreqPrecision::FULL:
+        memcpy(term_freqs, data, count * sizeof(double));
+        break;
+    case TermFreqPrecision::BITS_16:
+        ReadQuantized<uint16_t>(data, count, block_max_term_freqs_[block], term_freqs);
+        break;
+    case TermFreqPrecision::BITS_8:
+        ReadQuantized<uint8_t>(data, count, block_max_term_freqs_[block], term_freqs);
+        break;
+    }
+    return count;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bits kept of every term frequency in CompressedPostings
+enum class TermFreqPrecision {
+    // The exact double
+    FULL,
+    // Quantized against the largest term frequency of the block
+    BITS_16,
+    BITS_8,
+};
+
+// Read-only posting list packed in blocks of BLOCK_SIZE postings. A full block stores the gaps between
+// its ordinals bit-packed at the width of the largest gap, interleaved over four 32-bit lanes so that
+// SSE2 unpacks four gaps at once; the last, shorter block stores them as varints. Term frequencies
+// follow the gaps of each block at the chosen precision. The last ordinal of every block is kept
+// aside, so a range scan decodes only the blocks overlapping the range
+class CompressedPostings {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+
+    CompressedPostings() = default;
+
+    // The ordinals must be ascending and the term frequencies positive
+    CompressedPostings(const std::vector<int>& ordinals, const std::vector<double>& term_freqs, TermFreqPrecision precision);
+
+    // Calls function(ordinal, term_freq) for the postings with ordinals in [first_ordinal, last_ordinal), in ordinal order
+    template <typename Function>
+    void ForEachInRange(int first_ordinal, int last_ordinal, Function function) const {
+        int ordinals[BLOCK_SIZE];
+        double term_freqs[BLOCK_SIZE];
+        size_t block = std::lower_bound(block_last_ordinals_.begin(), block_last_ordinals_.end(), first_ordinal) - block_last_ordinals_.begin();
+        for (; block < block_last_ordinals_.size(); ++block) {
+            const size_t count = DecodeBlock(block, ordinals, term_freqs);
+            if (ordinals[0] >= last_ordinal) {
+                return;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (ordinals[i] >= first_ordinal && ordinals[i] < last_ordinal) {
+                    function(ordinals[i], term_freqs[i]);
+                }
+            }
+        }
+    }
+
+    bool Contains(int ordinal) const;
+
+    // Decodes all postings in order
+    void Decode(std::vector<int>& ordinals, std::vector<double>& term_freqs) const;
+
+    size_t size() const {
+        return count_;
+    }
+
+    size_t GetMemoryUsage() const {
+        return block_last_ordinals_.capacity() * sizeof(int)
+            + block_offsets_.capacity() * sizeof(uint32_t)
+            + block_max_term_freqs_.capacity() * sizeof(double)
+            + data_.capacity();
+    }
+
+private:
+    TermFreqPrecision precision_ = TermFreqPrecision::FULL;
+    size_t count_ = 0;
+    std::vector<int> block_last_ordinals_;
+    // Offset of every block in data_
+    std::vector<uint32_t> block_offsets_;
+    // Scales of the quantized term frequencies, empty at full precision
+    std::vector<double> block_max_term_freqs_;
+    std::vector<uint8_t> data_;
+
+    // Writes the ordinals and term frequencies of the block to the arrays and returns their count
+    size_t DecodeBlock(size_t block, int* ordinals, double* term_freqs) const;
+};
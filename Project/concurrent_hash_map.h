@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std::string_literals;
+
+// Open-addressing hash table of arithmetic values for concurrent writers.
+// Adding to a key is lock-free: a new key claims an empty slot with a CAS and an existing
+// key is updated with an atomic add, so summing relevances needs no mutex. Reads are lock-free,
+// and only Erase and the revival of an erased key take one of the stripe locks.
+// The capacity is fixed at construction; exceeding it throws std::length_error
+template <typename Key, typename Value>
+class ConcurrentHashMap {
+public:
+    static_assert(std::is_integral_v<Key>, "ConcurrentHashMap supports only integer keys"s);
+    static_assert(std::is_arithmetic_v<Value>, "ConcurrentHashMap supports only arithmetic values"s);
+
+    // Room for max_key_count keys at a load factor of at most one half
+    explicit ConcurrentHashMap(size_t max_key_count)
+        : slots_(RoundUpToPowerOfTwo(std::max<size_t>(max_key_count * 2, 2)))
+        , mask_(slots_.size() - 1) {
+    }
+
+    void Add(Key key, Value delta) {
+        size_t index = GetHome(key);
+        for (size_t probe = 0; probe < slots_.size(); ++probe, index = (index + 1) & mask_) {
+            Slot& slot = slots_[index];
+            State state = slot.state.load(std::memory_order_acquire);
+            if (state == State::EMPTY) {
+                State expected = State::EMPTY;
+                if (slot.state.compare_exchange_strong(expected, State::BUSY, std::memory_order_acquire)) {
+                    slot.key = key;
+                    slot.value.store(delta, std::memory_order_relaxed);
+                    slot.state.store(State::FULL, std::memory_order_release);
+                    return;
+                }
+                state = expected;
+            }
+            if (state == State::BUSY) {
+                state = WaitWhileBusy(slot);
+            }
+            if (slot.key != key) {
+                continue;
+            }
+            if (state == State::ERASED && Revive(slot, key, delta)) {
+                return;
+            }
+            AtomicAdd(slot.value, delta);
+            return;
+        }
+        throw std::length_error("ConcurrentHashMap is full"s);
+    }
+
+    bool Contains(Key key) const {
+        const Slot* slot = FindSlot(key);
+        return slot != nullptr && slot->state.load(std::memory_order_acquire) == State::FULL;
+    }
+
+    // Returns Value{} for a missing key
+    Value Get(Key key) const {
+        const Slot* slot = FindSlot(key);
+        if (slot == nullptr || slot->state.load(std::memory_order_acquire) != State::FULL) {
+            return Value{};
+        }
+        return slot->value.load(std::memory_order_relaxed);
+    }
+
+    bool Erase(Key key) {
+        Slot* slot = const_cast<Slot*>(FindSlot(key));
+        if (slot == nullptr) {
+            return false;
+        }
+        std::lock_guard guard(GetStripe(key));
+        if (slot->state.load(std::memory_order_relaxed) != State::FULL) {
+            return false;
+        }
+        slot->state.store(State::ERASED, std::memory_order_release);
+        return true;
+    }
+
+    // Calls function(key, value) for every present key in table order.
+    // Concurrent writers may or may not be observed
+    template <typename Function>
+    void ForEach(Function function) const {
+        for (const Slot& slot : slots_) {
+            if (slot.state.load(std::memory_order_acquire) == State::FULL) {
+                function(slot.key, slot.value.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+private:
+    enum class State : uint8_t {
+        EMPTY,
+        BUSY,
+        FULL,
+        ERASED,
+    };
+
+    struct Slot {
+        std::atomic<State> state{ State::EMPTY };
+        Key key{};
+        std::atomic<Value> value{};
+    };
+
+    static constexpr size_t STRIPE_COUNT = 64;
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    mutable std::array<std::mutex, STRIPE_COUNT> stripes_;
+
+    static size_t RoundUpToPowerOfTwo(size_t size) {
+        size_t result = 1;
+        while (result < size) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // Fibonacci hashing spreads consecutive ids over the table
+    static uint64_t Hash(Key key) {
+        return static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull;
+    }
+
+    size_t GetHome(Key key) const {
+        return static_cast<size_t>(Hash(key) >> 32) & mask_;
+    }
+
+    std::mutex& GetStripe(Key key) const {
+        return stripes_[Hash(key) % STRIPE_COUNT];
+    }
+
+    const Slot* FindSlot(Key key) const {
+        const size_t home = GetHome(key);
+        size_t index = home;
+        do {
+            const Slot& slot = slots_[index];
+            const State state = WaitWhileBusy(slot);
+            if (state == State::EMPTY) {
+                return nullptr;
+            }
+            if (slot.key == key) {
+                return &slot;
+            }
+            index = (index + 1) & mask_;
+        } while (index != home);
+        return nullptr;
+    }
+
+    // A slot is busy only while its claimer writes the key, which a preempted claimer
+    // may not finish before the end of the waiter's time slice
+    static State WaitWhileBusy(const Slot& slot) {
+        State state = slot.state.load(std::memory_order_acquire);
+        while (state == State::BUSY) {
+            std::this_thread::yield();
+            state = slot.state.load(std::memory_order_acquire);
+        }
+        return state;
+    }
+
+    bool Revive(Slot& slot, Key key, Value delta) {
+        std::lock_guard guard(GetStripe(key));
+        if (slot.state.load(std::memory_order_relaxed) != State::ERASED) {
+            return false;
+        }
+        slot.value.store(delta, std::memory_order_relaxed);
+        slot.state.store(State::FULL, std::memory_order_release);
+        return true;
+    }
+
+    static void AtomicAdd(std::atomic<Value>& value, Value delta) {
+        if constexpr (std::is_integral_v<Value>) {
+            value.fetch_add(delta, std::memory_order_relaxed);
+        }
+        else {
+            Value current = value.load(std::memory_order_relaxed);
+            while (!value.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+            }
+        }
+    }
+};
@@ -52,8 +52,10 @@ public:
         return result;
     }
 
-    void erase(int document_id) {
-        buckets_[static_cast<uint64_t>(document_id) % buckets_.size()].map.erase(document_id);
+    void erase(const Key& key) {
+        auto& bucket = buckets_[static_cast<uint64_t>(key) % buckets_.size()];
+        std::lock_guard g(bucket.mutex);
+        bucket.map.erase(key);
     }
 
 private:
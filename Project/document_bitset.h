@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Set of document ordinals as a dense array of bits: one bit per ordinal,
+// so membership is a shift and a mask, and a set over 100k ordinals fits in 12.5 KB
+class DocumentBitset {
+public:
+
+    // Makes the set empty and able to hold ordinals in [0, size) without growing
+    void Assign(size_t size) {
+        words_.assign((size + WORD_BITS - 1) / WORD_BITS, 0);
+    }
+
+    // Grows as needed
+    void Insert(size_t ordinal) {
+        const size_t word = ordinal / WORD_BITS;
+        if (word >= words_.size()) {
+            words_.resize(word + 1, 0);
+        }
+        words_[word] |= uint64_t{ 1 } << (ordinal % WORD_BITS);
+    }
+
+    void Erase(size_t ordinal) {
+        const size_t word = ordinal / WORD_BITS;
+        if (word < words_.size()) {
+            words_[word] &= ~(uint64_t{ 1 } << (ordinal % WORD_BITS));
+        }
+    }
+
+    bool Contains(size_t ordinal) const {
+        const size_t word = ordinal / WORD_BITS;
+        return word < words_.size() && (words_[word] >> (ordinal % WORD_BITS) & 1) != 0;
+    }
+
+    // Scratch instance owned by the calling thread
+    static DocumentBitset& ForThisThread() {
+        static thread_local DocumentBitset bitset;
+        return bitset;
+    }
+
+private:
+    static constexpr size_t WORD_BITS = 64;
+
+    std::vector<uint64_t> words_;
+};
@@ -0,0 +1,54 @@
+#include "index_file.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t ALIGNMENT = 8;
+
+void WritePadding(ostream& output, uint64_t size) {
+    static const char zeros[ALIGNMENT] = {};
+    output.write(zeros, (ALIGNMENT - size % ALIGNMENT) % ALIGNMENT);
+}
+
+} // namespace
+
+IndexFileWriter::IndexFileWriter(std::ostream& output)
+    : output_(output)
+    , is_written_(INDEX_FILE_SECTION_COUNT, false)
+{
+    copy(begin(INDEX_FILE_MAGIC), end(INDEX_FILE_MAGIC), header_.magic);
+    header_.version = INDEX_FILE_VERSION;
+    header_.section_count = INDEX_FILE_SECTION_COUNT;
+    header_.file_size = sizeof(IndexFileHeader);
+    // Placeholder, overwritten by Finish
+    output_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    WritePadding(output_, header_.file_size);
+    header_.file_size += (ALIGNMENT - header_.file_size % ALIGNMENT) % ALIGNMENT;
+}
+
+void IndexFileWriter::WriteSection(IndexFileSection section, const void* data, uint64_t count, uint64_t element_size) {
+    header_.sections[section] = { header_.file_size, count };
+    is_written_[section] = true;
+
+    const uint64_t size = count * element_size;
+    output_.write(static_cast<const char*>(data), size);
+    WritePadding(output_, size);
+    header_.file_size += size + (ALIGNMENT - size % ALIGNMENT) % ALIGNMENT;
+}
+
+void IndexFileWriter::Finish() {
+    if (find(is_written_.begin(), is_written_.end(), false) != is_written_.end()) {
+        throw logic_error("Index file is missing a section"s);
+    }
+    output_.seekp(0);
+    output_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    output_.seekp(0, ios::end);
+    if (!output_) {
+        throw runtime_error("Failed to write the index file"s);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// Binary index file written by SearchServer::Save and served by MappedSearchServer.
+// The file is a header followed by flat arrays, each starting at a multiple of 8 bytes,
+// so a mapped file is read in place. Numbers are stored in the byte order of the host.
+//
+// Documents are numbered densely in id order and terms in lexicographic order, which lets
+// the reader find both by binary search. The postings of term t are entries
+// [posting_offsets[t], posting_offsets[t + 1]) of the posting arrays, sorted by document number;
+// the words of document d are entries [forward_offsets[d], forward_offsets[d + 1]) of the forward
+// arrays, sorted by term number. Strings are stored as offsets into a character blob
+
+inline constexpr char INDEX_FILE_MAGIC[8] = { 'S', 'R', 'C', 'H', 'I', 'D', 'X', '\0' };
+// Bumped on every change of the layout; files of other versions are rejected
+inline constexpr uint32_t INDEX_FILE_VERSION = 1;
+
+enum IndexFileSection : uint32_t {
+    STOP_WORD_OFFSETS,     // uint64_t[stop word count + 1]
+    STOP_WORD_CHARS,       // char[]
+    TERM_OFFSETS,          // uint64_t[term count + 1]
+    TERM_CHARS,            // char[]
+    POSTING_OFFSETS,       // uint64_t[term count + 1]
+    POSTING_DOCUMENTS,     // int32_t[posting count]
+    POSTING_TERM_FREQS,    // double[posting count]
+    DOCUMENT_IDS,          // int32_t[document count]
+    DOCUMENT_RATINGS,      // int32_t[document count]
+    DOCUMENT_STATUSES,     // int32_t[document count]
+    FORWARD_OFFSETS,       // uint64_t[document count + 1]
+    FORWARD_TERMS,         // uint32_t[forward entry count]
+    FORWARD_TERM_FREQS,    // double[forward entry count]
+    INDEX_FILE_SECTION_COUNT,
+};
+
+struct IndexFileHeader {
+    struct Range {
+        uint64_t offset;
+        // Number of elements, not bytes
+        uint64_t count;
+    };
+
+    char magic[8];
+    uint32_t version;
+    uint32_t section_count;
+    uint64_t file_size;
+    Range sections[INDEX_FILE_SECTION_COUNT];
+};
+
+// Appends sections to a stream and writes the header last, into the space reserved for it
+class IndexFileWriter {
+public:
+    explicit IndexFileWriter(std::ostream& output);
+
+    template <typename T>
+    void WriteSection(IndexFileSection section, const std::vector<T>& data) {
+        WriteSection(section, data.data(), data.size(), sizeof(T));
+    }
+
+    void WriteSection(IndexFileSection section, std::string_view chars) {
+        WriteSection(section, chars.data(), chars.size(), 1);
+    }
+
+    // Every section must have been written by now
+    void Finish();
+
+private:
+    std::ostream& output_;
+    IndexFileHeader header_{};
+    std::vector<bool> is_written_;
+
+    void WriteSection(IndexFileSection section, const void* data, uint64_t count, uint64_t element_size);
+};
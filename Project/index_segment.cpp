@@ -0,0 +1,110 @@
+#include "index_segment.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+int IndexSegment::FindOrdinal(const SearchServer& index, int document_id) {
+    const auto it = index.document_ordinals_.find(document_id);
+    return it == index.document_ordinals_.end() ? -1 : it->second;
+}
+
+int IndexSegment::FindOrdinal(int document_id) const {
+    const int ordinal = FindOrdinal(*index, document_id);
+    if (ordinal == -1 || removed_ordinals.Contains(ordinal)) {
+        return -1;
+    }
+    return ordinal;
+}
+
+int IndexSegment::GetDocumentFreq(std::string_view word) const {
+    const PostingList* postings = index->FindPostings(word);
+    if (postings == nullptr) {
+        return 0;
+    }
+    int document_freq = static_cast<int>(postings->size());
+    if (const auto it = removed_document_freqs.find(index->terms_.Find(word)); it != removed_document_freqs.end()) {
+        document_freq -= it->second;
+    }
+    return document_freq;
+}
+
+void IndexSegment::MarkRemoved(int document_id) {
+    removed_ordinals.Add(index->document_ordinals_.at(document_id), 1.0);
+    for (const auto& [term_id, term_freq] : index->document_to_word_freqs_.at(document_id)) {
+        ++removed_document_freqs[term_id];
+    }
+}
+
+void IndexSegment::Resolve(const std::vector<std::pair<std::string_view, double>>& plus_words,
+    const std::vector<std::string_view>& minus_words, SearchServer::ResolvedQuery& resolved_query) const {
+    resolved_query.plus_postings.clear();
+    resolved_query.minus_postings.clear();
+    resolved_query.plus_posting_count = 0;
+    for (const auto& [word, inverse_document_freq] : plus_words) {
+        if (const PostingList* postings = index->FindPostings(word)) {
+            resolved_query.plus_postings.push_back({ postings, inverse_document_freq });
+            resolved_query.plus_posting_count += postings->size();
+        }
+    }
+    for (const string_view word : minus_words) {
+        if (const PostingList* postings = index->FindPostings(word)) {
+            resolved_query.minus_postings.push_back(postings);
+        }
+    }
+    if (!removed_ordinals.empty()) {
+        resolved_query.minus_postings.push_back(&removed_ordinals);
+    }
+}
+
+std::shared_ptr<IndexSegment> IndexSegment::Merge(const SearchServer& empty_index, const std::vector<std::shared_ptr<const IndexSegment>>& sources) {
+    auto merged_index = make_shared<SearchServer>(empty_index);
+    SearchServer::WordFreqs word_freqs;
+    for (const auto& source : sources) {
+        const SearchServer& source_index = *source->index;
+        for (const auto& [document_id, ordinal] : source_index.document_ordinals_) {
+            if (source->removed_ordinals.Contains(ordinal)) {
+                continue;
+            }
+            word_freqs.clear();
+            for (const auto& [term_id, term_freq] : source_index.document_to_word_freqs_.at(document_id)) {
+                word_freqs.push_back({ source_index.terms_.GetTerm(term_id), term_freq });
+            }
+            merged_index->IndexDocument(document_id, source_index.ordinal_statuses_[ordinal], source_index.ordinal_ratings_[ordinal], word_freqs);
+        }
+    }
+    return make_shared<IndexSegment>(IndexSegment{ move(merged_index) });
+}
+
+SegmentQuery::SegmentQuery(const SearchServer& parser, std::string_view raw_query)
+    : context_(SearchServer::QueryContext::ForThisThread())
+    , plus_words_([]() -> vector<pair<string_view, double>>& {
+        static thread_local vector<pair<string_view, double>> plus_words;
+        return plus_words;
+        }())
+{
+    parser.ParseQuery(raw_query, context_);
+    plus_words_.clear();
+    for (const string_view word : context_.query_.plus_words) {
+        plus_words_.push_back({ word, 0.0 });
+    }
+}
+
+void SegmentQuery::CountDocumentFreqs(const IndexSegment& segment) {
+    for (auto& [word, document_freq] : plus_words_) {
+        document_freq += segment.GetDocumentFreq(word);
+    }
+}
+
+void SegmentQuery::SetDocumentCount(int document_count) {
+    // The same minuend as SearchServer::log_document_count_ and the same expression as
+    // SearchServer::ComputeWordInverseDocumentFreq, so the relevances match bit for bit
+    const double log_document_count = log(static_cast<double>(document_count));
+    plus_words_.erase(remove_if(plus_words_.begin(), plus_words_.end(), [](const pair<string_view, double>& word) {
+        return word.second == 0.0;
+        }), plus_words_.end());
+    for (auto& [word, document_freq] : plus_words_) {
+        document_freq = log_document_count - log(document_freq);
+    }
+}
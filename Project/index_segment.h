@@ -0,0 +1,131 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "posting_list.h"
+#include "search_server.h"
+#include "term_dictionary.h"
+#include "top_documents.h"
+
+// Segments shared by SegmentedSearchServer and SnapshotSearchServer. A segment is a SearchServer
+// holding part of the documents, with tombstones for the ones removed since it was built.
+// Segments are scored against corpus-wide document frequencies, so an index split into
+// segments gives the same results as a single SearchServer with all its live documents
+struct IndexSegment {
+    std::shared_ptr<const SearchServer> index;
+    // Ordinals of the documents removed since the index was built
+    PostingList removed_ordinals = {};
+    // Removed documents containing each term, by term id of the index
+    std::unordered_map<TermId, int> removed_document_freqs = {};
+
+    // Live documents
+    int GetDocumentCount() const {
+        return index->GetDocumentCount() - static_cast<int>(removed_ordinals.size());
+    }
+
+    // Ordinal of the document in the index, -1 if the index does not hold it
+    static int FindOrdinal(const SearchServer& index, int document_id);
+
+    // Ordinal of the document if the segment holds it and it is not removed, -1 otherwise
+    int FindOrdinal(int document_id) const;
+
+    // Live documents containing the word
+    int GetDocumentFreq(std::string_view word) const;
+
+    // Tombstones a live document of the segment
+    void MarkRemoved(int document_id);
+
+    // Posting lists of the query words in the index, with the given inverse document frequencies
+    // of the plus words. The removed documents are excluded as if they had a minus word
+    void Resolve(const std::vector<std::pair<std::string_view, double>>& plus_words,
+        const std::vector<std::string_view>& minus_words, SearchServer::ResolvedQuery& resolved_query) const;
+
+    // One segment of the live documents of the sources, built on a copy of the empty index so that it
+    // shares its stop words and executor. Term frequencies are copied from the forward indexes, so no
+    // text is tokenized again
+    static std::shared_ptr<IndexSegment> Merge(const SearchServer& empty_index, const std::vector<std::shared_ptr<const IndexSegment>>& sources);
+};
+
+// Decides which segments to merge, so that a document is copied O(log n) times
+class TieredMergePolicy {
+public:
+    // Segments merged at once; also the size ratio between neighbouring tiers
+    static constexpr size_t MERGE_FACTOR = 4;
+    // A segment with more tombstones is rewritten, which bounds the tombstones copied with it
+    static constexpr size_t MAX_REMOVED_COUNT = 1024;
+
+    // Segments smaller than MERGE_FACTOR times the base count form the lowest tier
+    explicit TieredMergePolicy(size_t base_document_count)
+        : base_document_count_(base_document_count) {
+    }
+
+    // Too many tombstones, or more than live documents
+    bool NeedsRewrite(const IndexSegment& segment) const {
+        const size_t removed_count = segment.removed_ordinals.size();
+        return removed_count > MAX_REMOVED_COUNT || removed_count * 2 > static_cast<size_t>(segment.index->GetDocumentCount());
+    }
+
+    // The segments to merge next, or none if the segments are in shape. A segment that needs a rewrite
+    // is rewritten on its own. Otherwise segments fall into tiers by live size, each tier MERGE_FACTOR
+    // times larger than the previous one, and a tier that has gathered MERGE_FACTOR segments is merged
+    // into one segment of the next tier
+    template <typename SegmentPtr>
+    std::vector<SegmentPtr> PickSegmentsToMerge(const std::vector<SegmentPtr>& segments) const {
+        for (const SegmentPtr& segment : segments) {
+            if (NeedsRewrite(*segment)) {
+                return { segment };
+            }
+        }
+
+        std::map<int, std::vector<SegmentPtr>> tiers;
+        for (const SegmentPtr& segment : segments) {
+            int tier = 0;
+            for (size_t size = base_document_count_ * MERGE_FACTOR; size <= static_cast<size_t>(segment->GetDocumentCount()); size *= MERGE_FACTOR) {
+                ++tier;
+            }
+            auto& tier_segments = tiers[tier];
+            tier_segments.push_back(segment);
+            if (tier_segments.size() == MERGE_FACTOR) {
+                return tier_segments;
+            }
+        }
+        return {};
+    }
+
+private:
+    size_t base_document_count_;
+};
+
+// Query over a set of segments. The document frequencies of its plus words are counted over all
+// segments first, then every segment is scored with the same inverse document frequencies.
+// Its memory belongs to the calling thread, so a thread runs one such query at a time
+class SegmentQuery {
+public:
+    // Parsed with the stop words of the parser; throws if the query is invalid
+    SegmentQuery(const SearchServer& parser, std::string_view raw_query);
+
+    // Adds the live documents of the segment containing each plus word
+    void CountDocumentFreqs(const IndexSegment& segment);
+
+    // Turns the counted document frequencies into inverse ones. Words found in no live
+    // document are dropped, as SearchServer::ResolveQuery drops unknown words
+    void SetDocumentCount(int document_count);
+
+    // Pushes the documents of the segment that match the query and the predicate. A StatusPredicate
+    // is tested against the status bitsets of the segment, as in SearchServer
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    void FindDocuments(ExecutionPolicy policy, const IndexSegment& segment, DocumentPredicate document_predicate, TopDocuments& top_documents) const {
+        segment.Resolve(plus_words_, context_.query_.minus_words, context_.resolved_query_);
+        segment.index->FindAllDocuments(policy, context_.resolved_query_, document_predicate, top_documents);
+    }
+
+private:
+    SearchServer::QueryContext& context_;
+    // Plus words with their document frequencies, then with their inverse document frequencies
+    std::vector<std::pair<std::string_view, double>>& plus_words_;
+};
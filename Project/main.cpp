@@ -6,6 +6,7 @@
 #include "request_queue.h"
 #include "log_duration.h"
 #include "process_queries.h"
+#include "test_example_functions.h"
 
 #define PROFILE_CONCAT_INTERNAL(X, Y) X##Y
 #define PROFILE_CONCAT(X, Y) PROFILE_CONCAT_INTERNAL(X, Y)
@@ -27,51 +28,6 @@
 
 using namespace std;
 
-using namespace std;
-
-string GenerateWord(mt19937& generator, int max_length) {
-    const int length = uniform_int_distribution(1, max_length)(generator);
-    string word;
-    word.reserve(length);
-    for (int i = 0; i < length; ++i) {
-        word.push_back(uniform_int_distribution('a', 'z')(generator));
-    }
-    return word;
-}
-
-vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
-    vector<string> words;
-    words.reserve(word_count);
-    for (int i = 0; i < word_count; ++i) {
-        words.push_back(GenerateWord(generator, max_length));
-    }
-    words.erase(unique(words.begin(), words.end()), words.end());
-    return words;
-}
-
-string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob = 0) {
-    string query;
-    for (int i = 0; i < word_count; ++i) {
-        if (!query.empty()) {
-            query.push_back(' ');
-        }
-        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
-            query.push_back('-');
-        }
-        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
-    }
-    return query;
-}
-
-vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
-    vector<string> queries;
-    queries.reserve(query_count);
-    for (int i = 0; i < query_count; ++i) {
-        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
-    }
-    return queries;
-}
-
 template <typename ExecutionPolicy>
 void Test(string_view mark, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
     LOG_DURATION(mark);
@@ -86,7 +42,64 @@ void Test(string_view mark, const SearchServer& search_server, const vector<stri
 
 #define TEST(policy) Test(#policy, search_server, queries, execution::policy)
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        const string_view benchmark = argv[1];
+        if (benchmark == "layouts"sv) {
+            BenchmarkIndexLayouts();
+        }
+        else if (benchmark == "remove"sv) {
+            BenchmarkRemoveDocuments();
+        }
+        else if (benchmark == "add"sv) {
+            BenchmarkAddDocuments();
+        }
+        else if (benchmark == "concurrent-maps"sv) {
+            BenchmarkConcurrentMaps();
+        }
+        else if (benchmark == "query-sizes"sv) {
+            BenchmarkQuerySizes();
+        }
+        else if (benchmark == "segments"sv) {
+            BenchmarkSegmentedIndex();
+        }
+        else if (benchmark == "startup"sv) {
+            BenchmarkIndexStartup();
+        }
+        else if (benchmark == "tokenizer"sv) {
+            BenchmarkTokenizer();
+        }
+        else if (benchmark == "query-cache"sv) {
+            BenchmarkQueryCache();
+        }
+        else if (benchmark == "query-filters"sv) {
+            BenchmarkQueryFilters();
+        }
+        else if (benchmark == "query-pruning"sv) {
+            BenchmarkQueryPruning();
+        }
+        else if (benchmark == "compression"sv) {
+            BenchmarkCompression();
+        }
+        else if (benchmark == "process-queries"sv) {
+            BenchmarkProcessQueries();
+        }
+        else if (benchmark == "query-batches"sv) {
+            BenchmarkQueryBatches();
+        }
+        else if (benchmark == "match"sv) {
+            BenchmarkMatchDocuments();
+        }
+        else if (benchmark == "request-queue"sv) {
+            BenchmarkRequestQueue();
+        }
+        else {
+            cerr << "Unknown benchmark "s << benchmark << endl;
+            return 1;
+        }
+        return 0;
+    }
+
     mt19937 generator;
 
     const auto dictionary = GenerateDictionary(generator, 1000, 10);
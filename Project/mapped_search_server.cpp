@@ -0,0 +1,228 @@
+#include "mapped_search_server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+MappedSearchServer::MappedSearchServer(const std::string& path) {
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        throw runtime_error("Cannot open index file "s + path + ": "s + strerror(errno));
+    }
+    struct stat file_status;
+    if (fstat(file, &file_status) != 0 || file_status.st_size == 0) {
+        close(file);
+        throw invalid_argument("Index file "s + path + " is empty"s);
+    }
+    mapping_size_ = static_cast<size_t>(file_status.st_size);
+    mapping_ = mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps its own reference to the file
+    close(file);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        throw runtime_error("Cannot map index file "s + path + ": "s + strerror(errno));
+    }
+
+    try {
+        ReadSections();
+    }
+    catch (...) {
+        munmap(mapping_, mapping_size_);
+        throw;
+    }
+    log_document_count_ = log(static_cast<double>(document_count_));
+}
+
+MappedSearchServer::~MappedSearchServer() {
+    munmap(mapping_, mapping_size_);
+}
+
+std::vector<Document> MappedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
+        return document_status == status;
+        });
+}
+
+std::vector<Document> MappedSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> MappedSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    const QueryWords& query = ParseQuery(raw_query);
+
+    const int document = FindDocument(document_id);
+    if (document < 0) {
+        return { {}, {} };
+    }
+    const DocumentStatus status = static_cast<DocumentStatus>(document_statuses_[document]);
+    const auto contains = [this, document](string_view word) {
+        const uint32_t term = FindTerm(word);
+        return term != NO_TERM && DocumentContainsTerm(document, term);
+    };
+
+    if (any_of(query.minus_words.begin(), query.minus_words.end(), contains)) {
+        return { vector<string_view>{}, status };
+    }
+    vector<string_view> matched_words;
+    copy_if(query.plus_words.begin(), query.plus_words.end(), back_inserter(matched_words), contains);
+    return { matched_words, status };
+}
+
+int MappedSearchServer::GetDocumentCount() const {
+    return static_cast<int>(document_count_);
+}
+
+std::vector<std::pair<std::string_view, double>> MappedSearchServer::GetWordFrequencies(int document_id) const {
+    const int document = FindDocument(document_id);
+    if (document < 0) {
+        return {};
+    }
+    // Terms are numbered in lexicographic order, so the entries come sorted by word
+    vector<pair<string_view, double>> word_freqs;
+    word_freqs.reserve(forward_offsets_[document + 1] - forward_offsets_[document]);
+    for (uint64_t i = forward_offsets_[document]; i < forward_offsets_[document + 1]; ++i) {
+        word_freqs.push_back({ GetTerm(forward_terms_[i]), forward_term_freqs_[i] });
+    }
+    return word_freqs;
+}
+
+void MappedSearchServer::ReadSections() {
+    using Range = IndexFileHeader::Range;
+
+    if (mapping_size_ < sizeof(IndexFileHeader)) {
+        throw invalid_argument("Index file is truncated"s);
+    }
+    const auto* header = static_cast<const IndexFileHeader*>(mapping_);
+    if (memcmp(header->magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC)) != 0) {
+        throw invalid_argument("Not an index file"s);
+    }
+    if (header->version != INDEX_FILE_VERSION || header->section_count != INDEX_FILE_SECTION_COUNT) {
+        throw invalid_argument("Unsupported index file version "s + to_string(header->version));
+    }
+    if (header->file_size != mapping_size_) {
+        throw invalid_argument("Index file is truncated"s);
+    }
+
+    const char* base = static_cast<const char*>(mapping_);
+    const auto section = [&](IndexFileSection section, size_t element_size, uint64_t expected_count) {
+        const Range& range = header->sections[section];
+        if (range.count != expected_count || range.offset % element_size != 0
+            || range.offset > mapping_size_ || range.count > (mapping_size_ - range.offset) / element_size) {
+            throw invalid_argument("Index file section "s + to_string(section) + " is corrupt"s);
+        }
+        return base + range.offset;
+    };
+    const auto count = [header](IndexFileSection section) {
+        return header->sections[section].count;
+    };
+
+    if (count(STOP_WORD_OFFSETS) == 0 || count(TERM_OFFSETS) == 0 || count(FORWARD_OFFSETS) == 0) {
+        throw invalid_argument("Index file is corrupt"s);
+    }
+    stop_word_count_ = count(STOP_WORD_OFFSETS) - 1;
+    term_count_ = count(TERM_OFFSETS) - 1;
+    document_count_ = count(FORWARD_OFFSETS) - 1;
+
+    stop_word_offsets_ = reinterpret_cast<const uint64_t*>(section(STOP_WORD_OFFSETS, sizeof(uint64_t), stop_word_count_ + 1));
+    stop_word_chars_ = section(STOP_WORD_CHARS, 1, stop_word_offsets_[stop_word_count_]);
+    term_offsets_ = reinterpret_cast<const uint64_t*>(section(TERM_OFFSETS, sizeof(uint64_t), term_count_ + 1));
+    term_chars_ = section(TERM_CHARS, 1, term_offsets_[term_count_]);
+    posting_offsets_ = reinterpret_cast<const uint64_t*>(section(POSTING_OFFSETS, sizeof(uint64_t), term_count_ + 1));
+    const uint64_t posting_count = posting_offsets_[term_count_];
+    posting_documents_ = reinterpret_cast<const int32_t*>(section(POSTING_DOCUMENTS, sizeof(int32_t), posting_count));
+    posting_term_freqs_ = reinterpret_cast<const double*>(section(POSTING_TERM_FREQS, sizeof(double), posting_count));
+    document_ids_ = reinterpret_cast<const int32_t*>(section(DOCUMENT_IDS, sizeof(int32_t), document_count_));
+    document_ratings_ = reinterpret_cast<const int32_t*>(section(DOCUMENT_RATINGS, sizeof(int32_t), document_count_));
+    document_statuses_ = reinterpret_cast<const int32_t*>(section(DOCUMENT_STATUSES, sizeof(int32_t), document_count_));
+    forward_offsets_ = reinterpret_cast<const uint64_t*>(section(FORWARD_OFFSETS, sizeof(uint64_t), document_count_ + 1));
+    const uint64_t forward_entry_count = forward_offsets_[document_count_];
+    forward_terms_ = reinterpret_cast<const uint32_t*>(section(FORWARD_TERMS, sizeof(uint32_t), forward_entry_count));
+    forward_term_freqs_ = reinterpret_cast<const double*>(section(FORWARD_TERM_FREQS, sizeof(double), forward_entry_count));
+
+    // Offsets must not decrease, or the ranges built from them would run past the sections
+    const auto is_monotonic = [](const uint64_t* offsets, size_t count) {
+        return offsets[0] == 0 && is_sorted(offsets, offsets + count);
+    };
+    if (!is_monotonic(stop_word_offsets_, stop_word_count_ + 1) || !is_monotonic(term_offsets_, term_count_ + 1)
+        || !is_monotonic(posting_offsets_, term_count_ + 1) || !is_monotonic(forward_offsets_, document_count_ + 1)) {
+        throw invalid_argument("Index file is corrupt"s);
+    }
+
+    // Postings and forward entries index the document columns and the terms
+    if (any_of(posting_documents_, posting_documents_ + posting_count, [this](int32_t document) {
+        return document < 0 || static_cast<size_t>(document) >= document_count_;
+        })) {
+        throw invalid_argument("Index file section "s + to_string(POSTING_DOCUMENTS) + " is corrupt"s);
+    }
+    if (any_of(forward_terms_, forward_terms_ + forward_entry_count, [this](uint32_t term) {
+        return term >= term_count_;
+        })) {
+        throw invalid_argument("Index file section "s + to_string(FORWARD_TERMS) + " is corrupt"s);
+    }
+}
+
+std::string_view MappedSearchServer::GetStopWord(size_t index) const {
+    return { stop_word_chars_ + stop_word_offsets_[index], stop_word_offsets_[index + 1] - stop_word_offsets_[index] };
+}
+
+std::string_view MappedSearchServer::GetTerm(uint32_t term) const {
+    return { term_chars_ + term_offsets_[term], term_offsets_[term + 1] - term_offsets_[term] };
+}
+
+bool MappedSearchServer::IsStopWord(std::string_view word) const {
+    size_t first = 0;
+    size_t last = stop_word_count_;
+    while (first < last) {
+        const size_t middle = first + (last - first) / 2;
+        if (GetStopWord(middle) < word) {
+            first = middle + 1;
+        }
+        else {
+            last = middle;
+        }
+    }
+    return first < stop_word_count_ && GetStopWord(first) == word;
+}
+
+uint32_t MappedSearchServer::FindTerm(std::string_view word) const {
+    uint32_t first = 0;
+    uint32_t last = static_cast<uint32_t>(term_count_);
+    while (first < last) {
+        const uint32_t middle = first + (last - first) / 2;
+        if (GetTerm(middle) < word) {
+            first = middle + 1;
+        }
+        else {
+            last = middle;
+        }
+    }
+    return first < term_count_ && GetTerm(first) == word ? first : NO_TERM;
+}
+
+int MappedSearchServer::FindDocument(int document_id) const {
+    const int32_t* end = document_ids_ + document_count_;
+    const int32_t* it = lower_bound(document_ids_, end, document_id);
+    return it != end && *it == document_id ? static_cast<int>(it - document_ids_) : -1;
+}
+
+bool MappedSearchServer::DocumentContainsTerm(int document, uint32_t term) const {
+    return binary_search(forward_terms_ + forward_offsets_[document], forward_terms_ + forward_offsets_[document + 1], term);
+}
+
+const QueryWords& MappedSearchServer::ParseQuery(std::string_view text) const {
+    // Parsing allocates nothing once the buffers have grown
+    static thread_local vector<string_view> words;
+    static thread_local QueryWords query;
+    ParseQueryWords(text, [this](string_view word) {
+        return IsStopWord(word);
+        }, words, query);
+    return query;
+}
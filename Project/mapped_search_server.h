@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+#include "index_file.h"
+#include "relevance_accumulator.h"
+#include "string_processing.h"
+#include "top_documents.h"
+
+// Read-only search server over an index file written by SearchServer::Save.
+// The file is mapped into memory and queried in place, without building any maps.
+// Opening an index only validates the offsets, postings and forward index in one pass,
+// and the remaining pages are read by the system as queries touch them. Results are
+// the same as those of the SearchServer that saved the file
+class MappedSearchServer {
+public:
+    // Throws std::runtime_error if the file cannot be mapped
+    // and std::invalid_argument if it is not a valid index file of this version
+    explicit MappedSearchServer(const std::string& path);
+
+    MappedSearchServer(const MappedSearchServer&) = delete;
+    MappedSearchServer& operator=(const MappedSearchServer&) = delete;
+
+    ~MappedSearchServer();
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        const QueryWords& query = ParseQuery(raw_query);
+
+        auto& document_to_relevance = RelevanceAccumulator::ForThisThread();
+        document_to_relevance.Reset(document_count_);
+
+        for (const std::string_view word : query.minus_words) {
+            const uint32_t term = FindTerm(word);
+            if (term == NO_TERM) {
+                continue;
+            }
+            for (uint64_t i = posting_offsets_[term]; i < posting_offsets_[term + 1]; ++i) {
+                document_to_relevance.Exclude(posting_documents_[i]);
+            }
+        }
+
+        for (const std::string_view word : query.plus_words) {
+            const uint32_t term = FindTerm(word);
+            if (term == NO_TERM) {
+                continue;
+            }
+            const uint64_t document_freq = posting_offsets_[term + 1] - posting_offsets_[term];
+            const double inverse_document_freq = log_document_count_ - std::log(static_cast<double>(document_freq));
+            for (uint64_t i = posting_offsets_[term]; i < posting_offsets_[term + 1]; ++i) {
+                const int document = posting_documents_[i];
+                if (document_predicate(document_ids_[document], static_cast<DocumentStatus>(document_statuses_[document]), document_ratings_[document])) {
+                    document_to_relevance.Add(document, posting_term_freqs_[i] * inverse_document_freq);
+                }
+            }
+        }
+
+        TopDocuments top_documents(max_count);
+        document_to_relevance.ForEach([this, &top_documents](int document, double relevance) {
+            top_documents.Push({ document_ids_[document], relevance, document_ratings_[document] });
+            });
+        document_to_relevance.Clear();
+        return top_documents.Extract();
+    }
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+
+    // Words of the document with their term frequencies, sorted by word; empty for an unknown id.
+    // The views point into the mapped file
+    std::vector<std::pair<std::string_view, double>> GetWordFrequencies(int document_id) const;
+
+private:
+    static constexpr uint32_t NO_TERM = UINT32_MAX;
+
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+
+    // Sections of the mapped file, see index_file.h
+    size_t stop_word_count_ = 0;
+    const uint64_t* stop_word_offsets_ = nullptr;
+    const char* stop_word_chars_ = nullptr;
+    size_t term_count_ = 0;
+    const uint64_t* term_offsets_ = nullptr;
+    const char* term_chars_ = nullptr;
+    const uint64_t* posting_offsets_ = nullptr;
+    const int32_t* posting_documents_ = nullptr;
+    const double* posting_term_freqs_ = nullptr;
+    size_t document_count_ = 0;
+    const int32_t* document_ids_ = nullptr;
+    const int32_t* document_ratings_ = nullptr;
+    const int32_t* document_statuses_ = nullptr;
+    const uint64_t* forward_offsets_ = nullptr;
+    const uint32_t* forward_terms_ = nullptr;
+    const double* forward_term_freqs_ = nullptr;
+
+    double log_document_count_ = 0.0;
+
+    // Checks the header and the bounds of every section, and that every offset, posting and forward
+    // entry stays in bounds, then sets the section pointers. This reads the offsets, the postings and
+    // the forward index once at startup; term bytes, frequencies and document columns are not read
+    void ReadSections();
+
+    std::string_view GetStopWord(size_t index) const;
+
+    std::string_view GetTerm(uint32_t term) const;
+
+    bool IsStopWord(std::string_view word) const;
+
+    uint32_t FindTerm(std::string_view word) const;
+
+    // Document number of the id, or -1
+    int FindDocument(int document_id) const;
+
+    bool DocumentContainsTerm(int document, uint32_t term) const;
+
+    // The words are kept in memory of the calling thread, valid until its next query
+    const QueryWords& ParseQuery(std::string_view text) const;
+};
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "compressed_postings.h"
+
+// Posting list of a single term: document ordinals and term frequencies are kept
+// in two parallel arrays sorted by ordinal, so a query walks contiguous memory.
+// Erased postings are only marked and squeezed out once they make up half of the list,
+// so removing a document costs O(log n) amortized per term.
+// The logarithm of the document frequency is kept up to date on every change, so the
+// inverse document frequency of the term is one subtraction at query time. A frozen list
+// also stores the TF-IDF score of every posting; any change unfreezes it.
+// Every block of BLOCK_SIZE postings keeps an upper bound of its term frequencies for pruned queries.
+// A compressed list keeps only a CompressedPostings and serves the ordinal-based reads; the positional
+// API is unavailable, and any change decompresses it first
+class PostingList {
+public:
+
+    void Add(int ordinal, double term_freq) {
+        Decompress();
+        Unfreeze();
+        if (ordinals_.empty() || ordinals_.back() < ordinal) {
+            ordinals_.push_back(ordinal);
+            term_freqs_.push_back(term_freq);
+            RaiseBlockMaxTermFreq(ordinals_.size() - 1);
+            UpdateLogDocumentFreq();
+            return;
+        }
+        const auto it = std::lower_bound(ordinals_.begin(), ordinals_.end(), ordinal);
+        const auto pos = it - ordinals_.begin();
+        if (it != ordinals_.end() && *it == ordinal) {
+            if (term_freqs_[pos] == ERASED) {
+                term_freqs_[pos] = term_freq;
+                --erased_count_;
+                UpdateLogDocumentFreq();
+            }
+            else {
+                term_freqs_[pos] += term_freq;
+            }
+            RaiseBlockMaxTermFreq(pos);
+        }
+        else {
+            ordinals_.insert(it, ordinal);
+            term_freqs_.insert(term_freqs_.begin() + pos, term_freq);
+            // Every following posting moved to the next position
+            RebuildBlockMaxTermFreqs();
+            UpdateLogDocumentFreq();
+        }
+    }
+
+    bool Erase(int ordinal) {
+        Decompress();
+        const auto it = std::lower_bound(ordinals_.begin(), ordinals_.end(), ordinal);
+        if (it == ordinals_.end() || *it != ordinal || term_freqs_[it - ordinals_.begin()] == ERASED) {
+            return false;
+        }
+        Unfreeze();
+        term_freqs_[it - ordinals_.begin()] = ERASED;
+        if (++erased_count_ * 2 > ordinals_.size()) {
+            Compact();
+        }
+        UpdateLogDocumentFreq();
+        return true;
+    }
+
+    bool Contains(int ordinal) const {
+        if (is_compressed_) {
+            return compressed_.Contains(ordinal);
+        }
+        const auto it = std::lower_bound(ordinals_.begin(), ordinals_.end(), ordinal);
+        return it != ordinals_.end() && *it == ordinal && term_freqs_[it - ordinals_.begin()] != ERASED;
+    }
+
+    // Calls function(ordinal, term_freq) for every posting in ordinal order
+    template <typename Function>
+    void ForEach(Function function) const {
+        if (is_compressed_) {
+            compressed_.ForEachInRange(0, std::numeric_limits<int>::max(), function);
+            return;
+        }
+        for (size_t i = 0; i < ordinals_.size(); ++i) {
+            if (term_freqs_[i] != ERASED) {
+                function(ordinals_[i], term_freqs_[i]);
+            }
+        }
+    }
+
+    // Same as ForEach, limited to ordinals in [first_ordinal, last_ordinal)
+    template <typename Function>
+    void ForEachInRange(int first_ordinal, int last_ordinal, Function function) const {
+        if (is_compressed_) {
+            compressed_.ForEachInRange(first_ordinal, last_ordinal, function);
+            return;
+        }
+        size_t i = std::lower_bound(ordinals_.begin(), ordinals_.end(), first_ordinal) - ordinals_.begin();
+        for (; i < ordinals_.size() && ordinals_[i] < last_ordinal; ++i) {
+            if (term_freqs_[i] != ERASED) {
+                function(ordinals_[i], term_freqs_[i]);
+            }
+        }
+    }
+
+    // Calls function(ordinal, score) for the postings in [first_ordinal, last_ordinal) of a frozen list
+    template <typename Function>
+    void ForEachScoreInRange(int first_ordinal, int last_ordinal, Function function) const {
+        size_t i = std::lower_bound(ordinals_.begin(), ordinals_.end(), first_ordinal) - ordinals_.begin();
+        for (; i < ordinals_.size() && ordinals_[i] < last_ordinal; ++i) {
+            function(ordinals_[i], scores_[i]);
+        }
+    }
+
+    // Postings are also addressed by position, erased ones included, for queries that skip through the list.
+    // First position at or after from whose ordinal is not less than the given one
+    size_t Seek(size_t from, int ordinal) const {
+        // Galloping: targets are usually close to the current position
+        size_t step = 1;
+        size_t to = from;
+        while (to < ordinals_.size() && ordinals_[to] < ordinal) {
+            from = to + 1;
+            to += step;
+            step *= 2;
+        }
+        to = std::min(to, ordinals_.size());
+        return std::lower_bound(ordinals_.begin() + from, ordinals_.begin() + to, ordinal) - ordinals_.begin();
+    }
+
+    int GetOrdinal(size_t position) const {
+        return ordinals_[position];
+    }
+
+    bool IsErased(size_t position) const {
+        return term_freqs_[position] == ERASED;
+    }
+
+    double GetTermFreq(size_t position) const {
+        return term_freqs_[position];
+    }
+
+    // Score of the posting in a frozen list
+    double GetScore(size_t position) const {
+        return scores_[position];
+    }
+
+    // Upper bound of the term frequencies at positions in [first, last)
+    double GetMaxTermFreq(size_t first, size_t last) const {
+        double max_term_freq = 0.0;
+        for (size_t block = first / BLOCK_SIZE; block * BLOCK_SIZE < last; ++block) {
+            max_term_freq = std::max(max_term_freq, block_max_term_freqs_[block]);
+        }
+        return max_term_freq;
+    }
+
+    // Natural logarithm of the number of documents containing the term
+    double GetLogDocumentFreq() const {
+        return log_document_freq_;
+    }
+
+    // Precomputes term_freq * inverse_document_freq for every posting
+    void Freeze(double inverse_document_freq) {
+        Decompress();
+        Compact();
+        scores_.resize(ordinals_.size());
+        for (size_t i = 0; i < ordinals_.size(); ++i) {
+            scores_[i] = term_freqs_[i] * inverse_document_freq;
+        }
+        is_frozen_ = true;
+    }
+
+    void Unfreeze() {
+        if (is_frozen_) {
+            scores_.clear();
+            scores_.shrink_to_fit();
+            is_frozen_ = false;
+        }
+    }
+
+    bool IsFrozen() const {
+        return is_frozen_;
+    }
+
+    // Replaces the arrays with their compressed form
+    void Compress(TermFreqPrecision precision) {
+        Decompress();
+        Unfreeze();
+        Compact();
+        compressed_ = CompressedPostings(ordinals_, term_freqs_, precision);
+        ordinals_.clear();
+        ordinals_.shrink_to_fit();
+        term_freqs_.clear();
+        term_freqs_.shrink_to_fit();
+        block_max_term_freqs_.clear();
+        block_max_term_freqs_.shrink_to_fit();
+        is_compressed_ = true;
+    }
+
+    // Quantized term frequencies stay as decoded
+    void Decompress() {
+        if (is_compressed_) {
+            compressed_.Decode(ordinals_, term_freqs_);
+            compressed_ = {};
+            is_compressed_ = false;
+            RebuildBlockMaxTermFreqs();
+        }
+    }
+
+    bool IsCompressed() const {
+        return is_compressed_;
+    }
+
+    size_t size() const {
+        if (is_compressed_) {
+            return compressed_.size();
+        }
+        return ordinals_.size() - erased_count_;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t GetMemoryUsage() const {
+        return sizeof(PostingList)
+            + ordinals_.capacity() * sizeof(int)
+            + term_freqs_.capacity() * sizeof(double)
+            + scores_.capacity() * sizeof(double)
+            + block_max_term_freqs_.capacity() * sizeof(double)
+            + compressed_.GetMemoryUsage();
+    }
+
+private:
+    // Term frequency of an erased posting; a stored one is always positive
+    static constexpr double ERASED = 0.0;
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    std::vector<int> ordinals_;
+    std::vector<double> term_freqs_;
+    size_t erased_count_ = 0;
+    double log_document_freq_ = 0.0;
+    std::vector<double> scores_;
+    bool is_frozen_ = false;
+    // Erasing a posting keeps the bound of its block, which stays an upper bound
+    std::vector<double> block_max_term_freqs_;
+    CompressedPostings compressed_;
+    bool is_compressed_ = false;
+
+    void UpdateLogDocumentFreq() {
+        log_document_freq_ = std::log(static_cast<double>(size()));
+    }
+
+    void Compact() {
+        size_t kept = 0;
+        for (size_t i = 0; i < ordinals_.size(); ++i) {
+            if (term_freqs_[i] != ERASED) {
+                ordinals_[kept] = ordinals_[i];
+                term_freqs_[kept] = term_freqs_[i];
+                ++kept;
+            }
+        }
+        ordinals_.resize(kept);
+        term_freqs_.resize(kept);
+        erased_count_ = 0;
+        RebuildBlockMaxTermFreqs();
+    }
+
+    void RaiseBlockMaxTermFreq(size_t position) {
+        const size_t block = position / BLOCK_SIZE;
+        if (block == block_max_term_freqs_.size()) {
+            block_max_term_freqs_.push_back(term_freqs_[position]);
+        }
+        else {
+            block_max_term_freqs_[block] = std::max(block_max_term_freqs_[block], term_freqs_[position]);
+        }
+    }
+
+    void RebuildBlockMaxTermFreqs() {
+        block_max_term_freqs_.clear();
+        for (size_t position = 0; position < term_freqs_.size(); ++position) {
+            RaiseBlockMaxTermFreq(position);
+        }
+    }
+};
@@ -1,27 +1,176 @@
 #include "process_queries.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <execution>
+#include <memory>
+#include <mutex>
 
+namespace {
 
+    // Query of the streaming window, run by whichever thread claims it first
+    struct QuerySlot {
+        enum State {
+            PENDING,
+            RUNNING,
+            DONE,
+        };
+
+        std::string query;
+        std::vector<Document> documents;
+        std::exception_ptr error;
+        std::atomic<int> state = DONE;
+    };
+
+    // Shared with the submitted tasks, which may outlive ProcessQueriesStreamed. A stale task finds
+    // its slot already claimed, or refilled with a later query that it may just as well run
+    struct QueryWindow {
+        QueryWindow(const SearchServer& search_server, size_t size)
+            : search_server(search_server)
+            , slots(size) {
+        }
+
+        void TryRun(QuerySlot& slot) {
+            int expected = QuerySlot::PENDING;
+            if (!slot.state.compare_exchange_strong(expected, QuerySlot::RUNNING)) {
+                return;
+            }
+            try {
+                slot.documents = search_server.FindTopDocuments(std::execution::par, slot.query);
+            }
+            catch (...) {
+                slot.error = std::current_exception();
+            }
+            {
+                std::lock_guard guard(mutex);
+                slot.state = QuerySlot::DONE;
+            }
+            slot_done.notify_all();
+        }
+
+        // Never waits for a query that has not started, so the caller may itself be a worker of the executor
+        void Wait(QuerySlot& slot) {
+            TryRun(slot);
+            std::unique_lock lock(mutex);
+            slot_done.wait(lock, [&slot] {
+                return slot.state == QuerySlot::DONE;
+                });
+        }
+
+        // Drops the queries not started yet and waits for the running ones, after which no task touches the server
+        void Cancel() {
+            for (QuerySlot& slot : slots) {
+                int expected = QuerySlot::PENDING;
+                slot.state.compare_exchange_strong(expected, QuerySlot::DONE);
+            }
+            std::unique_lock lock(mutex);
+            slot_done.wait(lock, [this] {
+                return std::all_of(slots.begin(), slots.end(), [](const QuerySlot& slot) {
+                    return slot.state == QuerySlot::DONE;
+                    });
+                });
+        }
+
+        const SearchServer& search_server;
+        std::vector<QuerySlot> slots;
+        std::mutex mutex;
+        std::condition_variable slot_done;
+    };
+
+}
 
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries)
 {
+    // Queries and the parts of each query share the executor of the server, so nesting does not oversubscribe cores
     std::vector<std::vector<Document>> result(queries.size());
-    std::transform(std::execution::par, queries.begin(), queries.end(), result.begin(),
-        [&search_server](const std::string& query) {
-            return search_server.FindTopDocuments(query);
+    search_server.GetExecutor().ParallelFor(queries.size(), [&search_server, &queries, &result](size_t i) {
+        result[i] = search_server.FindTopDocuments(std::execution::par, queries[i]);
+        });
+    return result;
+}
+
+std::vector<std::vector<Document>> ProcessQueriesBatched(const SearchServer& search_server, const std::vector<std::string>& queries)
+{
+    std::vector<std::vector<Document>> result(queries.size());
+    const size_t batch_count = (queries.size() + QUERY_BATCH_SIZE - 1) / QUERY_BATCH_SIZE;
+    search_server.GetExecutor().ParallelFor(batch_count, [&search_server, &queries, &result](size_t batch) {
+        const size_t first = batch * QUERY_BATCH_SIZE;
+        const size_t last = std::min(queries.size(), first + QUERY_BATCH_SIZE);
+        const std::vector<std::string_view> batch_queries(queries.begin() + first, queries.begin() + last);
+        auto batch_result = search_server.FindTopDocumentsBatch(batch_queries);
+        std::move(batch_result.begin(), batch_result.end(), result.begin() + first);
         });
     return result;
 }
 
 std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries)
 {
-    std::vector<Document>result;
-    for (const auto& documents : ProcessQueries(search_server, queries)) {
-        for (const auto& document : documents) {
-            result.push_back(std::move(document));
+    // Every query writes into its own fixed-size run of the buffer, and the runs are then closed up in place
+    std::vector<Document> result(queries.size() * MAX_RESULT_DOCUMENT_COUNT);
+    std::vector<size_t> counts(queries.size());
+    // Queries with a QueryContext are never cached, so with the cache enabled the queries run as in ProcessQueries
+    const bool is_cached = search_server.GetResultCacheStats().capacity > 0;
+    search_server.GetExecutor().ParallelFor(queries.size(), [&search_server, &queries, &result, &counts, is_cached](size_t i) {
+        const auto write = [&result, &counts, i](const std::vector<Document>& documents) {
+            std::copy(documents.begin(), documents.end(), result.begin() + i * MAX_RESULT_DOCUMENT_COUNT);
+            counts[i] = documents.size();
+        };
+        if (is_cached) {
+            write(search_server.FindTopDocuments(std::execution::par, queries[i]));
         }
+        else {
+            write(search_server.FindTopDocuments(SearchServer::QueryContext::ForThisThread(), queries[i]));
+        }
+        });
+    size_t size = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto run = result.begin() + i * MAX_RESULT_DOCUMENT_COUNT;
+        size = std::copy(run, run + counts[i], result.begin() + size) - result.begin();
     }
+    result.resize(size);
     return result;
 }
+
+void ProcessQueriesStreamed(const SearchServer& search_server, const std::function<bool(std::string&)>& next_query,
+    const std::function<void(std::vector<Document>&&)>& consume, size_t window_size)
+{
+    const auto window = std::make_shared<QueryWindow>(search_server, std::max<size_t>(window_size, 1));
+    std::vector<QuerySlot>& slots = window->slots;
+    ThreadPool& executor = search_server.GetExecutor();
+
+    // Query i lives in slot i % slots.size()
+    size_t read_count = 0;
+    size_t consumed_count = 0;
+    bool has_more_queries = true;
+    try {
+        while (true) {
+            while (has_more_queries && read_count - consumed_count < slots.size()) {
+                QuerySlot& slot = slots[read_count % slots.size()];
+                if (!next_query(slot.query)) {
+                    has_more_queries = false;
+                    break;
+                }
+                slot.state = QuerySlot::PENDING;
+                executor.Submit([window, &slot] {
+                    window->TryRun(slot);
+                    });
+                ++read_count;
+            }
+            if (consumed_count == read_count) {
+                return;
+            }
+            QuerySlot& slot = slots[consumed_count++ % slots.size()];
+            window->Wait(slot);
+            if (slot.error) {
+                std::rethrow_exception(std::exchange(slot.error, nullptr));
+            }
+            consume(std::move(slot.documents));
+        }
+    }
+    catch (...) {
+        window->Cancel();
+        throw;
+    }
+}
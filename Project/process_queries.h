@@ -2,10 +2,69 @@
 
 #include "document.h"
 #include "search_server.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <istream>
 #include <string>
+#include <utility>
 #include <vector>
 
+// Queries in flight at once in ProcessQueriesStreamed
+constexpr size_t DEFAULT_QUERY_WINDOW_SIZE = 1024;
 
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries);
 
-std::vector<Document>ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries);
\ No newline at end of file
+// Queries per SearchServer::FindTopDocumentsBatch call in ProcessQueriesBatched
+constexpr size_t QUERY_BATCH_SIZE = 64;
+
+// Same results as ProcessQueries. The queries run in batches, and the queries of a batch walk
+// the posting lists of the words they share once. Batches bypass the result cache of the server.
+// Each thread keeps a batch accumulator of up to QUERY_BATCH_SIZE * 4096 scores, about 2 MB,
+// and less on an index of fewer than 4096 documents
+std::vector<std::vector<Document>> ProcessQueriesBatched(const SearchServer& search_server, const std::vector<std::string>& queries);
+
+// Results of all queries one after another, written straight into a single buffer.
+// Served from the result cache of the server when it is enabled, as ProcessQueries is
+std::vector<Document>ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries);
+
+// next_query(query) fills in the next query and returns false at the end of the input. Queries run on the
+// executor of the server, and consume(documents) receives the results of each one in input order on the
+// calling thread. At most window_size queries and their results are held at once; while waiting for the
+// oldest one, the calling thread runs it itself if no worker has started it yet.
+// The first exception of a query or of consume is rethrown once the queries in flight have stopped
+void ProcessQueriesStreamed(const SearchServer& search_server, const std::function<bool(std::string&)>& next_query,
+    const std::function<void(std::vector<Document>&&)>& consume, size_t window_size = DEFAULT_QUERY_WINDOW_SIZE);
+
+// Queries from [first, last), read one at a time
+template <typename QueryIterator, typename Consumer>
+void ProcessQueriesStreamed(const SearchServer& search_server, QueryIterator first, QueryIterator last, Consumer consume,
+    size_t window_size = DEFAULT_QUERY_WINDOW_SIZE) {
+    ProcessQueriesStreamed(search_server, [&first, &last](std::string& query) {
+        if (first == last) {
+            return false;
+        }
+        query = *first;
+        ++first;
+        return true;
+        }, consume, window_size);
+}
+
+// One query per line of the input
+template <typename Consumer>
+void ProcessQueriesStreamed(const SearchServer& search_server, std::istream& input, Consumer consume,
+    size_t window_size = DEFAULT_QUERY_WINDOW_SIZE) {
+    ProcessQueriesStreamed(search_server, [&input](std::string& query) {
+        return static_cast<bool>(std::getline(input, query));
+        }, consume, window_size);
+}
+
+// Streaming ProcessQueriesJoined: writes the results of the queries from [first, last) to output in order
+template <typename QueryIterator, typename OutputIterator>
+OutputIterator ProcessQueriesJoined(const SearchServer& search_server, QueryIterator first, QueryIterator last, OutputIterator output,
+    size_t window_size = DEFAULT_QUERY_WINDOW_SIZE) {
+    ProcessQueriesStreamed(search_server, first, last, [&output](std::vector<Document>&& documents) {
+        output = std::move(documents.begin(), documents.end(), output);
+        }, window_size);
+    return output;
+}
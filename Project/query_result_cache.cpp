@@ -0,0 +1,120 @@
+#include "query_result_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+using namespace std;
+
+QueryResultCache::QueryResultCache(size_t capacity)
+    : capacity_(0)
+    , shard_count_(1) {
+    SetCapacity(capacity);
+}
+
+QueryResultCache::QueryResultCache(const QueryResultCache& other)
+    : QueryResultCache(other.capacity_.load()) {
+}
+
+QueryResultCache& QueryResultCache::operator=(const QueryResultCache& other) {
+    if (this != &other) {
+        SetCapacity(other.capacity_);
+    }
+    return *this;
+}
+
+bool QueryResultCache::IsEnabled() const {
+    return capacity_ > 0;
+}
+
+void QueryResultCache::SetCapacity(size_t capacity) {
+    // All shards are locked at once, so no query sees some of them resized and others not
+    array<unique_lock<mutex>, SHARD_COUNT> locks;
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        locks[i] = unique_lock(shards_[i].mutex);
+    }
+    const size_t shard_count = clamp<size_t>(capacity / MIN_SHARD_CAPACITY, 1, SHARD_COUNT);
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        Shard& shard = shards_[i];
+        shard.Clear();
+        shard.capacity = i < shard_count ? capacity / shard_count + (i < capacity % shard_count ? 1 : 0) : 0;
+        shard.hit_count = 0;
+        shard.miss_count = 0;
+    }
+    capacity_ = capacity;
+    shard_count_ = shard_count;
+}
+
+std::optional<std::vector<Document>> QueryResultCache::Find(std::string_view normalized_query, DocumentStatus status, size_t max_count, uint64_t generation) {
+    static thread_local string key;
+    MakeKey(normalized_query, status, max_count, key);
+
+    Shard& shard = GetShard(key);
+    lock_guard guard(shard.mutex);
+    if (shard.capacity == 0) {
+        return nullopt;
+    }
+    shard.CatchUp(generation);
+    const auto it = shard.entry_by_key.find(key);
+    if (generation != shard.generation || it == shard.entry_by_key.end()) {
+        ++shard.miss_count;
+        return nullopt;
+    }
+    ++shard.hit_count;
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    return it->second->documents;
+}
+
+void QueryResultCache::Insert(std::string_view normalized_query, DocumentStatus status, size_t max_count, uint64_t generation, const std::vector<Document>& documents) {
+    string key;
+    MakeKey(normalized_query, status, max_count, key);
+
+    Shard& shard = GetShard(key);
+    lock_guard guard(shard.mutex);
+    shard.CatchUp(generation);
+    // A result of an older generation is already stale
+    if (shard.capacity == 0 || generation != shard.generation || shard.entry_by_key.count(key) > 0) {
+        return;
+    }
+    if (shard.entries.size() == shard.capacity) {
+        shard.entry_by_key.erase(shard.entries.back().key);
+        shard.entries.pop_back();
+    }
+    shard.entries.push_front({ move(key), documents });
+    shard.entry_by_key.emplace(shard.entries.front().key, shard.entries.begin());
+}
+
+QueryResultCache::Stats QueryResultCache::GetStats() const {
+    Stats stats;
+    for (const Shard& shard : shards_) {
+        lock_guard guard(shard.mutex);
+        stats.hit_count += shard.hit_count;
+        stats.miss_count += shard.miss_count;
+        stats.size += shard.entries.size();
+    }
+    stats.capacity = capacity_;
+    return stats;
+}
+
+void QueryResultCache::MakeKey(std::string_view normalized_query, DocumentStatus status, size_t max_count, std::string& key) {
+    key.assign(normalized_query);
+    key += '\0';
+    key += to_string(static_cast<int>(status));
+    key += '\0';
+    key += to_string(max_count);
+}
+
+QueryResultCache::Shard& QueryResultCache::GetShard(std::string_view key) {
+    return shards_[hash<string_view>{}(key) % shard_count_];
+}
+
+void QueryResultCache::Shard::CatchUp(uint64_t generation) {
+    if (generation > this->generation) {
+        Clear();
+        this->generation = generation;
+    }
+}
+
+void QueryResultCache::Shard::Clear() {
+    entry_by_key.clear();
+    entries.clear();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+// LRU cache of FindTopDocuments results, keyed by the normalized query, the document status
+// and the result count. Entries belong to one generation of the index: the first access with
+// a newer generation empties the cache. All methods are safe to call from several threads.
+// The keys are spread over shards with locks of their own, so parallel queries rarely wait
+// for each other. A copy is an empty cache of the same capacity, so copies of a server
+// never share results
+class QueryResultCache {
+public:
+    struct Stats {
+        uint64_t hit_count = 0;
+        uint64_t miss_count = 0;
+        size_t size = 0;
+        size_t capacity = 0;
+    };
+
+    // A cache of zero capacity is disabled: it keeps nothing and counts nothing
+    explicit QueryResultCache(size_t capacity = 0);
+
+    QueryResultCache(const QueryResultCache& other);
+    QueryResultCache& operator=(const QueryResultCache& other);
+
+    bool IsEnabled() const;
+
+    // Drops all entries and the counters
+    void SetCapacity(size_t capacity);
+
+    // Allocates nothing but the returned result once the key buffer of the calling thread has grown
+    std::optional<std::vector<Document>> Find(std::string_view normalized_query, DocumentStatus status, size_t max_count, uint64_t generation);
+
+    void Insert(std::string_view normalized_query, DocumentStatus status, size_t max_count, uint64_t generation, const std::vector<Document>& documents);
+
+    Stats GetStats() const;
+
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+    // Smaller shards would evict too early the keys that hash to the same shard
+    static constexpr size_t MIN_SHARD_CAPACITY = 16;
+
+    struct Entry {
+        std::string key;
+        std::vector<Document> documents;
+    };
+
+    // LRU cache of the keys that hash to it
+    struct Shard {
+        mutable std::mutex mutex;
+        size_t capacity = 0;
+        uint64_t generation = 0;
+        // Most recently used first
+        std::list<Entry> entries;
+        // Keys are views into the keys of the entries, which list nodes never move
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> entry_by_key;
+        uint64_t hit_count = 0;
+        uint64_t miss_count = 0;
+
+        // Empties the shard if the generation is newer than that of the entries. Called with the lock held
+        void CatchUp(uint64_t generation);
+
+        // Called with the lock held
+        void Clear();
+    };
+
+    // Atomic so that IsEnabled does not take a lock
+    std::atomic<size_t> capacity_;
+    // Shards in use, fewer for a small capacity
+    std::atomic<size_t> shard_count_;
+    std::array<Shard, SHARD_COUNT> shards_;
+
+    // Writes the key into the buffer, which keeps its capacity between calls
+    static void MakeKey(std::string_view normalized_query, DocumentStatus status, size_t max_count, std::string& key);
+
+    Shard& GetShard(std::string_view key);
+};
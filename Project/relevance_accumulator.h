@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Relevance scores in a flat array indexed by document ordinal. Ordinals that
+// received a score are remembered, so clearing costs O(touched) rather than O(size)
+class RelevanceAccumulator {
+public:
+
+    // Prepares the accumulator for ordinals in [0, size) and drops previous scores
+    void Reset(size_t size) {
+        Clear();
+        if (scores_.size() < size) {
+            scores_.resize(size, 0.0);
+            states_.resize(size, State::UNTOUCHED);
+        }
+    }
+
+    void Add(int ordinal, double relevance) {
+        switch (states_[ordinal]) {
+        case State::UNTOUCHED:
+            states_[ordinal] = State::SCORED;
+            touched_.push_back(ordinal);
+            scores_[ordinal] = relevance;
+            break;
+        case State::SCORED:
+            scores_[ordinal] += relevance;
+            break;
+        case State::EXCLUDED:
+            break;
+        }
+    }
+
+    // Drops the score of the ordinal and ignores further additions to it
+    void Exclude(int ordinal) {
+        if (states_[ordinal] == State::UNTOUCHED) {
+            touched_.push_back(ordinal);
+        }
+        states_[ordinal] = State::EXCLUDED;
+    }
+
+    // Calls function(ordinal, relevance) for every scored and not excluded ordinal
+    template <typename Function>
+    void ForEach(Function function) const {
+        for (const int ordinal : touched_) {
+            if (states_[ordinal] == State::SCORED) {
+                function(ordinal, scores_[ordinal]);
+            }
+        }
+    }
+
+    void Clear() {
+        for (const int ordinal : touched_) {
+            states_[ordinal] = State::UNTOUCHED;
+        }
+        touched_.clear();
+    }
+
+    // Instance owned by the calling thread; its buffers are reused across queries
+    static RelevanceAccumulator& ForThisThread() {
+        static thread_local RelevanceAccumulator accumulator;
+        return accumulator;
+    }
+
+private:
+    enum class State : uint8_t {
+        UNTOUCHED,
+        SCORED,
+        EXCLUDED,
+    };
+
+    std::vector<double> scores_;
+    std::vector<State> states_;
+    std::vector<int> touched_;
+};
@@ -1,28 +1,77 @@
 #include "request_queue.h"
 
-RequestQueue::RequestQueue(const SearchServer& search_server)
-    : server(search_server)
-{
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using namespace std::literals;
 
+RequestQueue::RequestQueue(const SearchServer& search_server, size_t capacity)
+    : server_(search_server)
+{
+    if (capacity > MAX_CAPACITY) {
+        throw std::invalid_argument("Request queue capacity is above "s + std::to_string(MAX_CAPACITY));
+    }
+    slots_ = std::vector<std::atomic<uint64_t>>(std::max<size_t>(capacity, 1));
 }
 
-std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) {
-    return AddFindRequest(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-        });
+std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query, DocumentStatus status) {
+    // The status overload of the server filters through its status bitsets and the result cache
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<Document> documents = server_.FindTopDocuments(raw_query, status);
+    Record(documents.size(), std::chrono::steady_clock::now() - start);
+    return documents;
 }
 
-std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query) {
+std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query) {
     return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
 }
 
-int RequestQueue::GetNoResultRequests() const {
-    int non_existant = 0;
-    for (size_t req_num = 0; req_num != requests_.size(); ++req_num) {
-        auto& ref = requests_.at(req_num).results;
-        if (ref.at(0).id == -1 && ref.at(0).rating == -1 && ref.size() == 1) {
-            ++non_existant;
+void RequestQueue::Record(size_t result_count, std::chrono::steady_clock::duration latency) {
+    const uint64_t sequence = next_sequence_.fetch_add(1, std::memory_order_relaxed);
+    const size_t index = sequence % slots_.size();
+    const uint64_t latency_us = std::clamp<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count(), 0, MAX_LATENCY_US);
+    const uint64_t record = ((sequence + 1) << SEQUENCE_SHIFT) | (result_count == 0 ? NO_RESULT_FLAG : 0) | latency_us;
+
+    // The slot holds the newest of the requests mapped to it; a request overtaken by a newer one
+    // before it got its slot has already left the window. Sequence fields are compared as the signed
+    // difference of the high bits, so the order holds across the wraparound of the field
+    std::atomic<uint64_t>& slot = slots_[index];
+    uint64_t evicted = slot.load(std::memory_order_relaxed);
+    do {
+        if (static_cast<int64_t>((record & SEQUENCE_MASK) - (evicted & SEQUENCE_MASK)) <= 0) {
+            return;
         }
+    } while (!slot.compare_exchange_weak(evicted, record, std::memory_order_relaxed));
+
+    // The first record of a slot only adds to the window, so the request count follows from the sequence
+    const int64_t no_result_delta = static_cast<int64_t>((record & NO_RESULT_FLAG) != 0) - static_cast<int64_t>((evicted & NO_RESULT_FLAG) != 0);
+    const int64_t latency_delta = static_cast<int64_t>(record & MAX_LATENCY_US) - static_cast<int64_t>(evicted & MAX_LATENCY_US);
+    // Wraps around as two's complement, so negative deltas subtract
+    const uint64_t delta = (static_cast<uint64_t>(latency_delta) << NO_RESULT_COUNT_BITS) + static_cast<uint64_t>(no_result_delta);
+    counters_[index % COUNTER_STRIPE_COUNT].value.fetch_add(delta, std::memory_order_relaxed);
+}
+
+int RequestQueue::GetNoResultRequests() const {
+    return static_cast<int>(GetStats().no_result_count);
+}
+
+RequestQueue::Stats RequestQueue::GetStats() const {
+    // Stripes updated after their loads may be off by the requests being recorded
+    uint64_t sum = 0;
+    for (const Counter& counter : counters_) {
+        sum += counter.value.load(std::memory_order_relaxed);
     }
-    return non_existant;
+    // The low field is sign-extended, and its borrow is returned to the latency sum
+    const int64_t no_result_count = static_cast<int64_t>(sum << (64 - NO_RESULT_COUNT_BITS)) >> (64 - NO_RESULT_COUNT_BITS);
+    const int64_t latency_us = static_cast<int64_t>(sum - static_cast<uint64_t>(no_result_count)) >> NO_RESULT_COUNT_BITS;
+
+    Stats stats;
+    stats.total_request_count = next_sequence_.load(std::memory_order_relaxed);
+    // Every slot is written once the ring has wrapped around
+    stats.request_count = static_cast<size_t>(std::min<uint64_t>(stats.total_request_count, slots_.size()));
+    stats.no_result_count = static_cast<size_t>(std::clamp<int64_t>(no_result_count, 0, stats.request_count));
+    stats.hit_count = stats.request_count - stats.no_result_count;
+    stats.total_latency_us = static_cast<uint64_t>(std::max<int64_t>(latency_us, 0));
+    return stats;
 }
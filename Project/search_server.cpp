@@ -2,6 +2,7 @@
 
 #include <cmath>
 
+#include "index_file.h"
 #include "string_processing.h"
 
 using namespace std;
@@ -21,38 +22,177 @@ void SearchServer::AddDocument(int document_id, std::string_view document, Docum
 
     using namespace std;
 
-    if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+    if ((document_id < 0) || (document_ordinals_.count(document_id) > 0)) {
         throw invalid_argument("Invalid document_id"s);
     }
-    vector<string_view> words = SplitIntoWordsNoStop(document);
+    WordFreqs word_freqs = ComputeWordFreqs(document);
+    ThawIndex();
+    IndexDocument(document_id, status, ComputeAverageRating(ratings), word_freqs);
+}
 
-    const double inv_word_count = 1.0 / words.size();
-    for (string_view& word : words) {
-        string s_word{ word };
-        if (strings_and_view_.count(s_word) == 0) {
-            strings_and_view_[s_word].first = s_word;
-            string_view sv_word{ strings_and_view_.at(s_word).first };
-            strings_and_view_.at(s_word).second = sv_word;
-        }
-        word_to_document_freqs_[strings_and_view_.at(s_word).second][document_id] += inv_word_count;
-        document_to_word_freqs_[document_id][strings_and_view_.at(s_word).second] += inv_word_count;
-    }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
-    document_ids_.insert(document_id);
+void SearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    AddDocuments(std::execution::seq, documents);
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {   
-    return FindTopDocuments(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-        });
+    return FindTopDocuments(std::execution::seq, raw_query, status);
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const {   
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(context, raw_query, StatusPredicate{ status });
+}
+
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, std::string_view raw_query) const {
+    return FindTopDocuments(context, raw_query, DocumentStatus::ACTUAL);
+}
+
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(const std::vector<std::string_view>& raw_queries, DocumentStatus status) const {
+    // Plus words of all queries by word, so each query receives the contributions of its words
+    // in the order FindTopDocuments adds them and gets bitwise the same relevances
+    struct BatchTerm {
+        string_view word;
+        size_t query;
+        const PostingList* postings;
+    };
+    vector<BatchTerm> terms;
+    vector<vector<const PostingList*>> minus_postings(raw_queries.size());
+    QueryContext& context = QueryContext::ForThisThread();
+    for (size_t query = 0; query < raw_queries.size(); ++query) {
+        ParseQuery(raw_queries[query], context);
+        for (const string_view word : context.query_.plus_words) {
+            if (const PostingList* postings = FindPostings(word)) {
+                terms.push_back({ word, query, postings });
+            }
+        }
+        for (const string_view word : context.query_.minus_words) {
+            if (const PostingList* postings = FindPostings(word)) {
+                minus_postings[query].push_back(postings);
+            }
+        }
+    }
+    stable_sort(terms.begin(), terms.end(), [](const BatchTerm& lhs, const BatchTerm& rhs) {
+        return lhs.word < rhs.word;
+        });
+
+    const DocumentBitset& allowed = status_ordinals_[static_cast<size_t>(status)];
+    BatchAccumulator& accumulator = BatchAccumulator::ForThisThread();
+    const int ordinal_count = static_cast<int>(ordinal_to_document_id_.size());
+    const int window_size = min(ordinal_count, BATCH_WINDOW_SIZE);
+    accumulator.Reset(raw_queries.size(), window_size);
+    vector<TopDocuments> top_documents(raw_queries.size(), TopDocuments(MAX_RESULT_DOCUMENT_COUNT));
+    for (int window_begin = 0; window_begin < ordinal_count && !terms.empty(); window_begin += window_size) {
+        const int window_end = min(ordinal_count, window_begin + window_size);
+        for (size_t query = 0; query < raw_queries.size(); ++query) {
+            for (const PostingList* postings : minus_postings[query]) {
+                postings->ForEachInRange(window_begin, window_end, [&accumulator, query, window_begin](int ordinal, double) {
+                    accumulator.Exclude(query, ordinal - window_begin);
+                    });
+            }
+        }
+        // Each run of terms with the same word is walked once
+        for (size_t first = 0, last = 0; first < terms.size(); first = last) {
+            while (last < terms.size() && terms[last].postings == terms[first].postings) {
+                ++last;
+            }
+            const auto scatter = [&, first, last](int ordinal, double relevance) {
+                if (!allowed.Contains(ordinal)) {
+                    return;
+                }
+                for (size_t i = first; i < last; ++i) {
+                    accumulator.Add(terms[i].query, ordinal - window_begin, relevance);
+                }
+            };
+            const PostingList& postings = *terms[first].postings;
+            if (is_index_frozen_) {
+                postings.ForEachScoreInRange(window_begin, window_end, scatter);
+                continue;
+            }
+            const double inverse_document_freq = ComputeWordInverseDocumentFreq(postings);
+            postings.ForEachInRange(window_begin, window_end, [&scatter, inverse_document_freq](int ordinal, double term_freq) {
+                scatter(ordinal, term_freq * inverse_document_freq);
+                });
+        }
+        for (size_t query = 0; query < raw_queries.size(); ++query) {
+            accumulator.ForEach(query, [this, &top_documents, query, window_begin](int offset, double relevance) {
+                const int ordinal = window_begin + offset;
+                top_documents[query].Push({ ordinal_to_document_id_[ordinal], relevance, ordinal_ratings_[ordinal] });
+                });
+        }
+        accumulator.Clear();
+    }
+
+    vector<vector<Document>> results;
+    results.reserve(raw_queries.size());
+    for (TopDocuments& query_top_documents : top_documents) {
+        results.push_back(query_top_documents.Extract());
+    }
+    return results;
+}
+
+SearchServer::PreparedQuery SearchServer::Prepare(std::string_view raw_query) const {
+    QueryContext& context = QueryContext::ForThisThread();
+    ParseQuery(raw_query, context);
+
+    string text;
+    WriteNormalizedText(context.query_, text);
+
+    PreparedQuery query;
+    query.text_ = make_shared<const string>(move(text));
+    // The words are laid out in the text in the order they were appended
+    const string_view text_view = *query.text_;
+    size_t pos = 0;
+    for (const string_view word : context.query_.plus_words) {
+        query.query_.plus_words.push_back(text_view.substr(pos, word.size()));
+        pos += word.size() + 1;
+    }
+    for (const string_view word : context.query_.minus_words) {
+        query.query_.minus_words.push_back(text_view.substr(pos + 1, word.size()));
+        pos += word.size() + 2;
+    }
+    query.server_ = this;
+    query.generation_ = generation_;
+    ResolveQuery(query.query_, query.resolved_query_);
+    return query;
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query, DocumentStatus status) const {
+    return FindTopDocuments(std::execution::seq, query, status);
+}
+
+void SearchServer::SetResultCacheCapacity(size_t capacity) {
+    result_cache_.SetCapacity(capacity);
+}
+
+QueryResultCache::Stats SearchServer::GetResultCacheStats() const {
+    return result_cache_.GetStats();
+}
+
+uint64_t SearchServer::GetGeneration() const {
+    return generation_;
+}
+
+void SearchServer::SetQueryMode(QueryMode mode) {
+    query_mode_ = mode;
+}
+
+SearchServer::QueryMode SearchServer::GetQueryMode() const {
+    return query_mode_;
+}
+
+void SearchServer::SetExecutor(ThreadPool& executor) {
+    executor_ = &executor;
+}
+
+ThreadPool& SearchServer::GetExecutor() const {
+    return *executor_;
+}
+
 int SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return document_ordinals_.size();
 }
 
 std::set<int>::const_iterator  SearchServer::begin() const {
@@ -63,19 +203,96 @@ std::set<int>::const_iterator  SearchServer::end() const {
     return document_ids_.end();
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {              
-
-    static std::map<std::string_view, double> document_to_word_freqs_view;
+WordFrequencies SearchServer::GetWordFrequencies(int document_id) const {
+    // Shared by all unknown ids; a const local static is initialized once and safe to read from any thread
+    static const std::vector<WordFrequencies::Entry> empty_word_freqs;
 
-    if (document_to_word_freqs_.count(document_id) && document_to_word_freqs_.at(document_id).size() != 0) {
-        document_to_word_freqs_view = document_to_word_freqs_.at(document_id);
-        return document_to_word_freqs_view;
+    const auto word_freqs = document_to_word_freqs_.find(document_id);
+    if (word_freqs == document_to_word_freqs_.end()) {
+        return { terms_, empty_word_freqs };
     }
-    else {
-        document_to_word_freqs_view = {};
-        return document_to_word_freqs_view;
+    return { terms_, word_freqs->second };
+}
+
+size_t SearchServer::GetIndexMemoryUsage() const {
+    size_t memory = terms_.GetMemoryUsage();
+    for (const PostingList& postings : word_to_document_freqs_) {
+        memory += postings.GetMemoryUsage();
     }
+    return memory;
+}
 
+void SearchServer::Save(std::ostream& output) const {
+    IndexFileWriter writer(output);
+
+    vector<uint64_t> stop_word_offsets{ 0 };
+    string stop_word_chars;
+    for (const string& stop_word : stop_words_) {
+        stop_word_chars += stop_word;
+        stop_word_offsets.push_back(stop_word_chars.size());
+    }
+    writer.WriteSection(STOP_WORD_OFFSETS, stop_word_offsets);
+    writer.WriteSection(STOP_WORD_CHARS, stop_word_chars);
+
+    // Terms are renumbered in lexicographic order, skipping the ids of erased terms
+    vector<TermId> term_ids;
+    for (TermId term_id = 0; term_id < word_to_document_freqs_.size(); ++term_id) {
+        if (!word_to_document_freqs_[term_id].empty()) {
+            term_ids.push_back(term_id);
+        }
+    }
+    sort(term_ids.begin(), term_ids.end(), [this](TermId lhs, TermId rhs) {
+        return terms_.GetTerm(lhs) < terms_.GetTerm(rhs);
+        });
+    vector<uint32_t> term_numbers(word_to_document_freqs_.size());
+    vector<uint64_t> term_offsets{ 0 };
+    string term_chars;
+    vector<uint64_t> posting_offsets{ 0 };
+    for (uint32_t term_number = 0; term_number < term_ids.size(); ++term_number) {
+        term_numbers[term_ids[term_number]] = term_number;
+        term_chars += terms_.GetTerm(term_ids[term_number]);
+        term_offsets.push_back(term_chars.size());
+        posting_offsets.push_back(posting_offsets.back() + word_to_document_freqs_[term_ids[term_number]].size());
+    }
+    writer.WriteSection(TERM_OFFSETS, term_offsets);
+    writer.WriteSection(TERM_CHARS, term_chars);
+    writer.WriteSection(POSTING_OFFSETS, posting_offsets);
+
+    // Documents are numbered in id order, so walking the forward index in that order
+    // fills every posting list sorted by document number
+    vector<int32_t> posting_documents(posting_offsets.back());
+    vector<double> posting_term_freqs(posting_offsets.back());
+    vector<uint64_t> posting_ends(posting_offsets.begin(), posting_offsets.end() - 1);
+    vector<int32_t> document_ids;
+    vector<int32_t> document_ratings;
+    vector<int32_t> document_statuses;
+    vector<uint64_t> forward_offsets{ 0 };
+    vector<uint32_t> forward_terms;
+    vector<double> forward_term_freqs;
+    for (const auto& [document_id, ordinal] : document_ordinals_) {
+        const int32_t document_number = static_cast<int32_t>(document_ids.size());
+        document_ids.push_back(document_id);
+        document_ratings.push_back(ordinal_ratings_[ordinal]);
+        document_statuses.push_back(static_cast<int32_t>(ordinal_statuses_[ordinal]));
+        for (const auto& [term_id, term_freq] : document_to_word_freqs_.at(document_id)) {
+            const uint32_t term_number = term_numbers[term_id];
+            const uint64_t posting = posting_ends[term_number]++;
+            posting_documents[posting] = document_number;
+            posting_term_freqs[posting] = term_freq;
+            forward_terms.push_back(term_number);
+            forward_term_freqs.push_back(term_freq);
+        }
+        forward_offsets.push_back(forward_terms.size());
+    }
+    writer.WriteSection(POSTING_DOCUMENTS, posting_documents);
+    writer.WriteSection(POSTING_TERM_FREQS, posting_term_freqs);
+    writer.WriteSection(DOCUMENT_IDS, document_ids);
+    writer.WriteSection(DOCUMENT_RATINGS, document_ratings);
+    writer.WriteSection(DOCUMENT_STATUSES, document_statuses);
+    writer.WriteSection(FORWARD_OFFSETS, forward_offsets);
+    writer.WriteSection(FORWARD_TERMS, forward_terms);
+    writer.WriteSection(FORWARD_TERM_FREQS, forward_term_freqs);
+    writer.Finish();
 }
 
 void SearchServer::RemoveDocument(int document_id) {
@@ -84,16 +301,19 @@ void SearchServer::RemoveDocument(int document_id) {
         return;
     }
 
-    for (auto it = word_to_document_freqs_.begin(); it != word_to_document_freqs_.end(); ++it) {
-        auto w_t_d_f_ = it->second.find(document_id);
-        if (w_t_d_f_ != it->second.end()) {
-            it->second.erase(w_t_d_f_);
-        }
+    ThawIndex();
+    const auto document = document_ordinals_.find(document_id);
+    const int ordinal = document->second;
+    for (const auto& [term_id, _] : document_to_word_freqs_.at(document_id)) {
+        word_to_document_freqs_[term_id].Erase(ordinal);
+        EraseTermIfUnused(term_id);
     }
 
-    documents_.erase(documents_.find(document_id));
+    document_ordinals_.erase(document);
+    UpdateDocumentCount();
+    ReleaseOrdinal(ordinal);
 
-    document_ids_.erase(find(document_ids_.begin(), document_ids_.end(), document_id));
+    document_ids_.erase(document_id);
 
     document_to_word_freqs_.erase(document_id);
 
@@ -103,107 +323,240 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     return MatchDocument(std::execution::seq, raw_query, document_id);
 }
 
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::sequenced_policy&, std::string_view raw_query, int document_id) const {   
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::sequenced_policy& policy, std::string_view raw_query, int document_id) const {
 
-    if (!IsValidWord(raw_query)) {
-        throw std::invalid_argument("Query is invalid");
+    QueryContext& context = QueryContext::ForThisThread();
+    ParseQuery(raw_query, context);
+
+    const auto word_freqs = document_to_word_freqs_.find(document_id);
+    if (word_freqs == document_to_word_freqs_.end()) {
+        return { {}, {} };
     }
+    const int ordinal = document_ordinals_.at(document_id);
+    return { MatchWords(policy, context.query_, word_freqs->second), ordinal_statuses_[ordinal] };
+}
 
-    const Query query = ParseQuery(raw_query);
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::parallel_policy& policy, std::string_view raw_query, int document_id) const {
 
-    if (document_ids_.count(document_id) == 0) {
+    QueryContext& context = QueryContext::ForThisThread();
+    ParseQuery(raw_query, context);
+
+    const auto word_freqs = document_to_word_freqs_.find(document_id);
+    if (word_freqs == document_to_word_freqs_.end()) {
         return { {}, {} };
-        //throw std::out_of_range("Invalid Argument");
     }
+    // The words of the one document are matched in parallel
+    const int ordinal = document_ordinals_.at(document_id);
+    return { MatchWords(policy, context.query_, word_freqs->second), ordinal_statuses_[ordinal] };
+}
 
-    std::vector<std::string_view> matched_words;
-    std::for_each(std::execution::seq, query.plus_words.begin(), query.plus_words.end(),
-        [this, &matched_words, &document_id](std::string_view word) {
-            if (!(this->word_to_document_freqs_.count(word) == 0)) {
-                if (this->word_to_document_freqs_.at(word).count(document_id)) {
-                    matched_words.push_back(word);
-                }
-            }});
+std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> SearchServer::MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids) const {
+    return MatchDocuments(std::execution::seq, raw_query, document_ids);
+}
 
-    std::any_of(std::execution::seq, query.minus_words.begin(), query.minus_words.end(),
-        [this, &matched_words, &document_id](std::string_view word) {
-            if (this->word_to_document_freqs_.count(word) == 0) {
-                return false;
-            }
-            if (this->word_to_document_freqs_.at(word).count(document_id)) {
-                matched_words.clear();
-                return true;
-            }
-            return true;
+bool SearchServer::HasWord(const std::vector<WordFrequencies::Entry>& word_freqs, std::string_view word) const {
+    const auto it = lower_bound(word_freqs.begin(), word_freqs.end(), word, [this](const WordFrequencies::Entry& entry, string_view word) {
+        return terms_.GetTerm(entry.first) < word;
         });
+    return it != word_freqs.end() && terms_.GetTerm(it->first) == word;
+}
+
+bool SearchServer::IsStopWord(const std::string_view& word) const {
+    return stop_words_.count(word) > 0;
+}
 
-    return { matched_words, documents_.at(document_id).status };
+
+bool SearchServer::IsValidWord(std::string_view word) {
+    return ::IsValidWord(word);
 }
 
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::parallel_policy&, std::string_view raw_query, int document_id) const {
+void SearchServer::SplitIntoWordsNoStop(std::string_view text, std::vector<std::string_view>& words) const {
 
-    if (!IsValidWord(raw_query)) {
-        throw std::invalid_argument("Query is invalid");
+    using namespace std;
+
+    if (!SplitIntoValidWords(text, words)) {
+        const string_view word = *find_if_not(words.begin(), words.end(), IsValidWord);
+        throw invalid_argument("Word "s + string(word) + " is invalid"s);
     }
+    words.erase(remove_if(words.begin(), words.end(), [this](string_view word) {
+        return IsStopWord(word);
+        }), words.end());
+}
 
-    const Query query = ParseQuery(raw_query);
+int SearchServer::AcquireOrdinal(int document_id, DocumentStatus status, int rating) {
+    int ordinal;
+    if (free_ordinals_.empty()) {
+        ordinal = static_cast<int>(ordinal_to_document_id_.size());
+        ordinal_to_document_id_.push_back(document_id);
+        ordinal_statuses_.push_back(status);
+        ordinal_ratings_.push_back(rating);
+    }
+    else {
+        ordinal = free_ordinals_.back();
+        free_ordinals_.pop_back();
+        ordinal_to_document_id_[ordinal] = document_id;
+        ordinal_statuses_[ordinal] = status;
+        ordinal_ratings_[ordinal] = rating;
+    }
+    status_ordinals_[static_cast<size_t>(status)].Insert(ordinal);
+    return ordinal;
+}
 
-    if (document_ids_.count(document_id) == 0) {
-        return { {}, {} };
-        //throw std::out_of_range("Invalid Argument");
+void SearchServer::ReleaseOrdinal(int ordinal) {
+    ordinal_to_document_id_[ordinal] = -1;
+    free_ordinals_.push_back(ordinal);
+    for (DocumentBitset& ordinals : status_ordinals_) {
+        ordinals.Erase(ordinal);
     }
+}
 
-    std::vector<std::string_view> matched_words;
-    std::for_each(std::execution::par, query.plus_words.begin(), query.plus_words.end(),
-        [this, &matched_words, &document_id](std::string_view word) {
-            if (!(this->word_to_document_freqs_.count(word) == 0)) {
-                if (this->word_to_document_freqs_.at(word).count(document_id)) {
-                    matched_words.push_back(word);
-                }
-            }});
+void SearchServer::EraseTermIfUnused(TermId term_id) {
+    if (word_to_document_freqs_[term_id].empty()) {
+        word_to_document_freqs_[term_id] = PostingList();
+        terms_.Erase(term_id);
+    }
+}
 
-    std::any_of(std::execution::par, query.minus_words.begin(), query.minus_words.end(),
-        [this, &matched_words, &document_id](std::string_view word) {
-            if (this->word_to_document_freqs_.count(word) == 0) {
-                return false;
-            }
-            if (this->word_to_document_freqs_.at(word).count(document_id)) {
-                matched_words.clear();
-                return true;
-            }
-            return true;
+const PostingList* SearchServer::FindPostings(std::string_view word) const {
+    const TermId term_id = terms_.Find(word);
+    if (term_id == TermDictionary::NO_TERM || word_to_document_freqs_[term_id].empty()) {
+        return nullptr;
+    }
+    return &word_to_document_freqs_[term_id];
+}
+
+void SearchServer::ResolveQuery(const Query& query, ResolvedQuery& result) const {
+    result.plus_postings.clear();
+    result.minus_postings.clear();
+    result.plus_posting_count = 0;
+    for (const std::string_view word : query.plus_words) {
+        if (const PostingList* postings = FindPostings(word)) {
+            result.plus_postings.push_back({ postings, ComputeWordInverseDocumentFreq(*postings) });
+            result.plus_posting_count += postings->size();
+        }
+    }
+    for (const std::string_view word : query.minus_words) {
+        if (const PostingList* postings = FindPostings(word)) {
+            result.minus_postings.push_back(postings);
+        }
+    }
+}
+
+void SearchServer::CollectTopDocuments(const RelevanceAccumulator& document_to_relevance, TopDocuments& top_documents) const {
+    document_to_relevance.ForEach([this, &top_documents](int ordinal, double relevance) {
+        const int document_id = ordinal_to_document_id_[ordinal];
+        top_documents.Push({ document_id, relevance, ordinal_ratings_[ordinal] });
         });
+}
 
-    return { matched_words, documents_.at(document_id).status };
+SearchServer::WordFreqs SearchServer::ComputeWordFreqs(std::string_view text) const {
+    // Reused across documents; the parallel AddDocuments tokenizes on several threads at once
+    static thread_local vector<string_view> words;
+    SplitIntoWordsNoStop(text, words);
+    sort(words.begin(), words.end());
+
+    const double inv_word_count = 1.0 / words.size();
+    WordFreqs word_freqs;
+    for (const string_view word : words) {
+        if (word_freqs.empty() || word_freqs.back().first != word) {
+            word_freqs.push_back({ word, 0.0 });
+        }
+        word_freqs.back().second += inv_word_count;
+    }
+    return word_freqs;
 }
 
-bool SearchServer::IsStopWord(const std::string_view& word) const {
-    return stop_words_.count(word) > 0;
+void SearchServer::CheckNewDocumentIds(const std::vector<NewDocument>& documents) const {
+    vector<int> document_ids;
+    document_ids.reserve(documents.size());
+    for (const NewDocument& document : documents) {
+        if ((document.id < 0) || (document_ordinals_.count(document.id) > 0)) {
+            throw invalid_argument("Invalid document_id"s);
+        }
+        document_ids.push_back(document.id);
+    }
+    sort(document_ids.begin(), document_ids.end());
+    if (adjacent_find(document_ids.begin(), document_ids.end()) != document_ids.end()) {
+        throw invalid_argument("Invalid document_id"s);
+    }
 }
 
+void SearchServer::IndexDocument(int document_id, DocumentStatus status, int rating, const WordFreqs& word_freqs) {
+    const int ordinal = AcquireOrdinal(document_id, status, rating);
+    // Created even for a document of stop words only, so that it can be removed later
+    auto& document_word_freqs = document_to_word_freqs_[document_id];
+    document_word_freqs.reserve(word_freqs.size());
+    for (const auto& [word, term_freq] : word_freqs) {
+        const TermId term_id = terms_.Intern(word);
+        if (term_id >= word_to_document_freqs_.size()) {
+            word_to_document_freqs_.resize(term_id + 1);
+        }
+        word_to_document_freqs_[term_id].Add(ordinal, term_freq);
+        document_word_freqs.push_back({ term_id, term_freq });
+    }
+    document_ordinals_.emplace(document_id, ordinal);
+    UpdateDocumentCount();
+    document_ids_.insert(document_id);
+}
 
-bool SearchServer::IsValidWord(std::string_view word) {
-    // A valid word must not contain special characters
-    return std::none_of(word.begin(), word.end(), [](char c) {
-        return c >= '\0' && c < ' ';
-        });
+void SearchServer::UpdateDocumentCount() {
+    log_document_count_ = log(static_cast<double>(document_ordinals_.size()));
+    ++generation_;
 }
 
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const {
+void SearchServer::FreezeIndex() {
+    ThawIndex();
+    for (PostingList& postings : word_to_document_freqs_) {
+        if (!postings.empty()) {
+            postings.Freeze(ComputeWordInverseDocumentFreq(postings));
+        }
+    }
+    is_index_frozen_ = true;
+}
 
-    using namespace std;
+bool SearchServer::IsIndexFrozen() const {
+    return is_index_frozen_;
+}
+
+void SearchServer::CompressIndex(TermFreqPrecision precision) {
+    ThawIndex();
+    for (PostingList& postings : word_to_document_freqs_) {
+        postings.Compress(precision);
+    }
+    is_index_compressed_ = true;
+    // Quantized term frequencies change the results of cached queries
+    ++generation_;
+}
 
-    vector<string_view> words;
-    for (const string_view word : SplitIntoWords(text)) {
-        if (!IsValidWord(word)) {
-            string s_word(word.begin(), word.end());
-            throw invalid_argument("Word "s + string(s_word) + " is invalid"s);
+bool SearchServer::IsIndexCompressed() const {
+    return is_index_compressed_;
+}
+
+void SearchServer::ThawIndex() {
+    if (is_index_compressed_) {
+        // The forward index keeps the exact term frequencies; walking it by ordinal appends every posting at the end
+        for (PostingList& postings : word_to_document_freqs_) {
+            postings = PostingList();
         }
-        if (!IsStopWord(word)) {
-            words.push_back(word);
+        for (int ordinal = 0; ordinal < static_cast<int>(ordinal_to_document_id_.size()); ++ordinal) {
+            const int document_id = ordinal_to_document_id_[ordinal];
+            if (document_id == -1) {
+                continue;
+            }
+            for (const auto& [term_id, term_freq] : document_to_word_freqs_.at(document_id)) {
+                word_to_document_freqs_[term_id].Add(ordinal, term_freq);
+            }
         }
+        is_index_compressed_ = false;
+        ++generation_;
     }
-    return words;
+    if (!is_index_frozen_) {
+        return;
+    }
+    for (PostingList& postings : word_to_document_freqs_) {
+        postings.Unfreeze();
+    }
+    is_index_frozen_ = false;
 }
 
 int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
@@ -217,42 +570,25 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const {
-
-    using namespace std;
-
-    if (text.empty()) {
-        throw invalid_argument("Query word is empty"s);
-    }
-    bool is_minus = false;
-    if (text[0] == '-') {
-        is_minus = true;
-        text = text.substr(1);
-    }
-    if (text.empty() || text[0] == '-' || !IsValidWord(text)) {
-        throw invalid_argument("Query word "s + string(text) + " is invalid"s);
-    }
-    return { text, is_minus, IsStopWord(text) };
+void SearchServer::ParseQuery(std::string_view text, QueryContext& context) const {
+    ParseQueryWords(text, [this](std::string_view word) {
+        return IsStopWord(word);
+        }, context.words_, context.query_);
 }
 
-
-SearchServer::Query SearchServer::ParseQuery(const std::string_view& text) const {
-    Query result = {};
-    for (const std::string_view word : SplitIntoWords(text)) {
-        QueryWord query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                result.minus_words.insert(query_word.data);
-            }
-            else {
-                result.plus_words.insert(query_word.data);
-            }
-        }
+void SearchServer::WriteNormalizedText(const Query& query, std::string& text) {
+    text.clear();
+    for (const std::string_view word : query.plus_words) {
+        text += text.empty() ? ""sv : " "sv;
+        text += word;
+    }
+    for (const std::string_view word : query.minus_words) {
+        text += text.empty() ? "-"sv : " -"sv;
+        text += word;
     }
-    return result;
 }
 
 // Existence required
-double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+double SearchServer::ComputeWordInverseDocumentFreq(const PostingList& postings) const {
+    return log_document_count_ - postings.GetLogDocumentFreq();
 } 
\ No newline at end of file
@@ -1,9 +1,14 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <execution>
 #include <future>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
 #include <set>
 #include <stdexcept>
 #include <string>
@@ -11,15 +16,106 @@
 #include <tuple>
 #include <vector>
 
+#include "batch_accumulator.h"
+#include "block_max_scorer.h"
 #include "document.h"
-#include "concurrent_map.h"
+#include "document_bitset.h"
 #include "log_duration.h"
+#include "posting_list.h"
+#include "query_result_cache.h"
+#include "relevance_accumulator.h"
+#include "sparse_document_set.h"
 #include "string_processing.h"
+#include "term_dictionary.h"
+#include "thread_pool.h"
+#include "top_documents.h"
+#include "word_frequencies.h"
 
 class SearchServer {
 
+    using Query = QueryWords;
+
+    // Posting lists of the query words present in the index, with the inverse document frequencies of plus words
+    struct ResolvedQuery {
+        std::vector<std::pair<const PostingList*, double>> plus_postings;
+        std::vector<const PostingList*> minus_postings;
+        size_t plus_posting_count = 0;
+    };
+
+    // Segments of the segmented servers are servers of their own, scored against corpus-wide
+    // document frequencies and filled from forward indexes without tokenizing again
+    friend struct IndexSegment;
+    friend class SegmentQuery;
+    // Tokenizes documents before taking its lock and indexes them under it
+    friend class SegmentedSearchServer;
+
+    // Lets the tests count the interned terms and the ordinal slots
+    friend struct SearchServerTestAccess;
+
 public:
 
+    // Predicate of the queries by status. Scoring recognizes it and tests the status bitsets
+    // instead of looking every posting's document up
+    struct StatusPredicate {
+        DocumentStatus status;
+
+        bool operator()(int document_id, DocumentStatus document_status, int rating) const {
+            return document_status == status;
+        }
+    };
+
+    // Scratch memory of a query: its words, the parsed and resolved query and the result.
+    // Buffers keep their capacity between queries, so once a context has served a query,
+    // queries of at most the same size and result count run without heap allocations.
+    // A context serves one query at a time
+    class QueryContext {
+    public:
+        // Documents found by the last FindTopDocuments made with this context
+        const std::vector<Document>& GetResult() const {
+            return result_;
+        }
+
+        // Context of the calling thread, used by the queries that do not take one
+        static QueryContext& ForThisThread() {
+            static thread_local QueryContext context;
+            return context;
+        }
+
+    private:
+        friend class SearchServer;
+        friend class SegmentQuery;
+
+        std::vector<std::string_view> words_;
+        Query query_;
+        // Key of the query in the result cache, see PreparedQuery::GetNormalizedText
+        std::string normalized_text_;
+        ResolvedQuery resolved_query_;
+        TopDocuments top_documents_{ 0 };
+        std::vector<Document> result_;
+    };
+
+    // Query parsed and resolved once to be run many times. After the index changes, running it
+    // resolves its words again, so it stays usable with any state of the server
+    class PreparedQuery {
+    public:
+        // Plus words, then minus words with their '-'; each group is sorted, without stop words and duplicates
+        std::string_view GetNormalizedText() const {
+            return *text_;
+        }
+
+    private:
+        friend class SearchServer;
+
+        PreparedQuery() = default;
+
+        // Shared, so that copies and moves leave the views of the query valid
+        std::shared_ptr<const std::string> text_;
+        Query query_;
+        const SearchServer* server_ = nullptr;
+        uint64_t generation_ = 0;
+        ResolvedQuery resolved_query_;
+    };
+
     template <typename StringContainer>
     explicit SearchServer(const StringContainer& stop_words)
         : stop_words_(MakeUniqueNonEmptyStrings(stop_words))  // Extract non-empty stop words
@@ -36,32 +132,165 @@ public:
 
     void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings); 
 
+    struct NewDocument {
+        int id;
+        std::string_view text;
+        DocumentStatus status;
+        std::vector<int> ratings;
+    };
+
+    // Tokenizes the documents and computes their term frequencies in parallel according to the policy,
+    // then merges them into the indexes in one pass. Nothing is added if any document is invalid
+    template <typename ExecutionPolicy>
+    void AddDocuments(ExecutionPolicy policy, const std::vector<NewDocument>& documents) {
+        CheckNewDocumentIds(documents);
+
+        std::vector<TokenizedDocument> tokenized_documents(documents.size());
+        RunFor(policy, documents.size(), [this, &documents, &tokenized_documents](size_t i) {
+            // The error is reported after all documents are tokenized, so the first invalid one wins
+            try {
+                tokenized_documents[i].word_freqs = ComputeWordFreqs(documents[i].text);
+            }
+            catch (const std::invalid_argument& error) {
+                tokenized_documents[i].error = error.what();
+            }
+            });
+
+        for (const TokenizedDocument& tokenized_document : tokenized_documents) {
+            if (!tokenized_document.error.empty()) {
+                throw std::invalid_argument(tokenized_document.error);
+            }
+        }
+
+        ThawIndex();
+        for (size_t i = 0; i < documents.size(); ++i) {
+            IndexDocument(documents[i].id, documents[i].status, ComputeAverageRating(documents[i].ratings), tokenized_documents[i].word_freqs);
+        }
+    }
+
+    void AddDocuments(const std::vector<NewDocument>& documents);
+
     std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
 
     std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
 
+    // Returns at most max_count best documents
     template <typename ExecutionPolicy, typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view& raw_query, DocumentPredicate document_predicate) const {
-        const auto query = ParseQuery(raw_query);
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view& raw_query, DocumentPredicate document_predicate, size_t max_count) const {
+        QueryContext& context = QueryContext::ForThisThread();
+        if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+            return FindTopDocuments(context, raw_query, document_predicate, max_count);
+        }
+        else {
+            ParseQuery(raw_query, context);
+            ResolveQuery(context.query_, context.resolved_query_);
 
-        auto matched_documents = FindAllDocuments(policy, query, document_predicate);
+            TopDocuments top_documents(max_count);
+            FindAllDocuments(policy, context.resolved_query_, document_predicate, top_documents);
 
-        sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-            return (std::abs(lhs.relevance - rhs.relevance) < 1e-6) ?
-                (lhs.rating > rhs.rating) : (lhs.relevance > rhs.relevance);
-            });
-        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+            return top_documents.Extract();
+        }
+    }
+
+    // Sequential search that keeps all its memory, the result included, in the context.
+    // The returned reference is context.GetResult()
+    template <typename DocumentPredicate>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        ParseQuery(raw_query, context);
+        ResolveQuery(context.query_, context.resolved_query_);
+
+        context.top_documents_.Reset(max_count);
+        FindAllDocuments(context.resolved_query_, document_predicate, context.top_documents_);
+        context.top_documents_.ExtractTo(context.result_);
+        return context.result_;
+    }
+
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentStatus status) const;
+
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query) const;
+
+    PreparedQuery Prepare(std::string_view raw_query) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const PreparedQuery& query, DocumentPredicate document_predicate, size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        const ResolvedQuery* resolved_query = &query.resolved_query_;
+        if (query.server_ != this || query.generation_ != generation_) {
+            QueryContext& context = QueryContext::ForThisThread();
+            ResolveQuery(query.query_, context.resolved_query_);
+            resolved_query = &context.resolved_query_;
         }
 
-        return matched_documents;
+        TopDocuments top_documents(max_count);
+        FindAllDocuments(policy, *resolved_query, document_predicate, top_documents);
+        return top_documents.Extract();
+    }
+
+    // Served from the result cache when it is enabled
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const PreparedQuery& query, DocumentStatus status = DocumentStatus::ACTUAL, size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        const bool is_cached = result_cache_.IsEnabled();
+        if (is_cached) {
+            if (auto documents = result_cache_.Find(query.GetNormalizedText(), status, max_count, generation_)) {
+                return std::move(*documents);
+            }
+        }
+        std::vector<Document> documents = FindTopDocuments(policy, query, StatusPredicate{ status }, max_count);
+        if (is_cached) {
+            result_cache_.Insert(query.GetNormalizedText(), status, max_count, generation_, documents);
+        }
+        return documents;
+    }
+
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query, DocumentStatus status = DocumentStatus::ACTUAL) const;
+
+    // Keeps the results of up to capacity queries by status; 0 disables the cache.
+    // Queries with a predicate or a QueryContext are never cached
+    void SetResultCacheCapacity(size_t capacity);
+
+    QueryResultCache::Stats GetResultCacheStats() const;
+
+    // Changes with every added or removed document
+    uint64_t GetGeneration() const;
+
+    enum class QueryMode {
+        // Scores every posting of the query words
+        EXHAUSTIVE,
+        // Skips the documents that cannot enter the top, see BlockMaxScorer; the results are the same
+        PRUNED,
+    };
+
+    void SetQueryMode(QueryMode mode);
+
+    QueryMode GetQueryMode() const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view& raw_query, DocumentStatus status, size_t max_count) const {
+        if (!result_cache_.IsEnabled()) {
+            return FindTopDocuments(policy, raw_query, StatusPredicate{ status }, max_count);
+        }
+        // The query is looked up by its normalized text, built in the context, so a hit allocates only the result
+        QueryContext& context = QueryContext::ForThisThread();
+        ParseQuery(raw_query, context);
+        WriteNormalizedText(context.query_, context.normalized_text_);
+        if (auto documents = result_cache_.Find(context.normalized_text_, status, max_count, generation_)) {
+            return std::move(*documents);
+        }
+        ResolveQuery(context.query_, context.resolved_query_);
+        TopDocuments top_documents(max_count);
+        FindAllDocuments(policy, context.resolved_query_, StatusPredicate{ status }, top_documents);
+        std::vector<Document> documents = top_documents.Extract();
+        result_cache_.Insert(context.normalized_text_, status, max_count, generation_, documents);
+        return documents;
+    }
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view& raw_query, DocumentPredicate document_predicate) const {
+        return FindTopDocuments(policy, raw_query, document_predicate, MAX_RESULT_DOCUMENT_COUNT);
     }
 
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view& raw_query, DocumentStatus status) const {
-        return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-            });
+        return FindTopDocuments(policy, raw_query, status, MAX_RESULT_DOCUMENT_COUNT);
     }
 
     template <typename ExecutionPolicy>
@@ -74,17 +303,79 @@ public:
         return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
     }
 
+    // Runs the queries as one batch over windows of ordinals: in every window, the posting list of each word is walked
+    // once for all the queries containing it. The results are those of FindTopDocuments(raw_query, status) for each query.
+    // Batches are never cached
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string_view>& raw_queries, DocumentStatus status = DocumentStatus::ACTUAL) const;
+
+    // All parallel work of the server runs on this pool; by default it is ThreadPool::GetDefault().
+    // The pool must outlive the server
+    void SetExecutor(ThreadPool& executor);
+
+    ThreadPool& GetExecutor() const;
+
     int GetDocumentCount() const;
 
     std::set<int>::const_iterator begin() const;
 
     std::set<int>::const_iterator end() const;
 
+    // Plus words of the query found in the document, sorted and without duplicates, and the status of the document.
+    // A minus word found in the document leaves no words. Words are looked up in the forward index of the document.
+    // The views point into raw_query
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy&, std::string_view raw_query, int document_id) const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy&, std::string_view raw_query, int document_id) const;
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;         
+    // MatchDocument for every document of a result page, parsing the query once.
+    // Documents run in parallel under the parallel policy; unknown ids get no words
+    template <typename ExecutionPolicy>
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(const ExecutionPolicy& policy, std::string_view raw_query,
+        const std::vector<int>& document_ids) const {
+        // Read by the workers, and left alone by the calling thread until they are done
+        QueryContext& context = QueryContext::ForThisThread();
+        ParseQuery(raw_query, context);
+        const Query& query = context.query_;
+
+        std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> result(document_ids.size());
+        RunFor(policy, document_ids.size(), [this, &query, &document_ids, &result](size_t i) {
+            const auto word_freqs = document_to_word_freqs_.find(document_ids[i]);
+            if (word_freqs != document_to_word_freqs_.end()) {
+                const int ordinal = document_ordinals_.at(document_ids[i]);
+                result[i] = { MatchWords(std::execution::seq, query, word_freqs->second), ordinal_statuses_[ordinal] };
+            }
+            });
+        return result;
+    }
+
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids) const;
+
+    // Read-only view into the forward index, sorted by word; unknown ids get a view of a shared empty entry.
+    // The view is valid until the document is removed. The words it yields are valid until the next
+    // RemoveDocument of any document, which may compact the term dictionary and move its bytes.
+    // Adding documents and running queries invalidate neither; copy the words to keep them longer
+    WordFrequencies GetWordFrequencies(int document_id) const;
+
+    // Approximate number of bytes held by the term dictionary and posting lists, counting
+    // the bytes of erased terms that the dictionary has not reclaimed yet
+    size_t GetIndexMemoryUsage() const;
+
+    // Precomputes the TF-IDF score of every posting, so that scoring a query is pure addition.
+    // The next AddDocument or RemoveDocument returns the index to the regular mode
+    void FreezeIndex();
+
+    bool IsIndexFrozen() const;
+
+    // Packs every posting list into delta-coded blocks with term frequencies at the given precision.
+    // Quantized term frequencies change relevances slightly. Pruned queries run exhaustively on a compressed
+    // index; FreezeIndex and the next AddDocument or RemoveDocument rebuild the lists from the forward index
+    void CompressIndex(TermFreqPrecision precision = TermFreqPrecision::FULL);
+
+    bool IsIndexCompressed() const;
+
+    // Writes the index in the format of index_file.h for MappedSearchServer.
+    // The stream must be binary and seekable, such as an std::ofstream opened with std::ios::binary
+    void Save(std::ostream& output) const;
 
     void RemoveDocument(int document_id);
 
@@ -95,17 +386,23 @@ public:
             return;
         }
 
-        std::for_each(policy, word_to_document_freqs_.begin(), word_to_document_freqs_.end(),
-            [&document_id](auto& to_erase) {
-                auto find_erase = to_erase.second.find(document_id);
-                if (find_erase != to_erase.second.end()) {
-                    to_erase.second.erase(find_erase);
-                }
+        ThawIndex();
+        const auto document = document_ordinals_.find(document_id);
+        const int ordinal = document->second;
+        const auto& word_freqs = document_to_word_freqs_.at(document_id);
+        RunFor(policy, word_freqs.size(), [this, ordinal, &word_freqs](size_t i) {
+            // Distinct terms own distinct posting lists
+            word_to_document_freqs_[word_freqs[i].first].Erase(ordinal);
             });
+        for (const auto& [term_id, _] : word_freqs) {
+            EraseTermIfUnused(term_id);
+        }
 
-        documents_.erase(documents_.find(document_id));
+        document_ordinals_.erase(document);
+        UpdateDocumentCount();
+        ReleaseOrdinal(ordinal);
 
-        document_ids_.erase(find(document_ids_.begin(), document_ids_.end(), document_id));
+        document_ids_.erase(document_id);
 
         document_to_word_freqs_.erase(document_id);
 
@@ -113,137 +410,249 @@ public:
 
 private:
 
-    struct DocumentData {
-        int rating;
-        DocumentStatus status;
-    };
-
     const std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
-    std::map<std::string, std::pair<std::string, std::string_view>> strings_and_view_;
-    std::map<int, DocumentData> documents_;
+    TermDictionary terms_;
+    // Posting lists indexed by term id
+    std::vector<PostingList> word_to_document_freqs_;
+    // Term ids and frequencies of every document, sorted by word
+    std::map<int, std::vector<WordFrequencies::Entry>> document_to_word_freqs_;
+    // Dense index of every document in posting lists, relevance accumulators and the columns below
+    std::map<int, int> document_ordinals_;
     std::set<int,std::less<>> document_ids_;
+    // Document columns indexed by ordinal, so that scoring reads them without a tree lookup.
+    // Free ordinals have the id -1 and stale statuses and ratings
+    std::vector<int> ordinal_to_document_id_;
+    std::vector<DocumentStatus> ordinal_statuses_;
+    std::vector<int> ordinal_ratings_;
+    std::vector<int> free_ordinals_;
+    ThreadPool* executor_ = &ThreadPool::GetDefault();
+    // Logarithm of the document count, the minuend of every inverse document frequency
+    double log_document_count_ = 0.0;
+    bool is_index_frozen_ = false;
+    bool is_index_compressed_ = false;
+    QueryMode query_mode_ = QueryMode::EXHAUSTIVE;
+    uint64_t generation_ = 0;
+    mutable QueryResultCache result_cache_;
+    // Ordinals of the documents of every status
+    std::array<DocumentBitset, static_cast<size_t>(DocumentStatus::REMOVED) + 1> status_ordinals_;
+
+    // Called on every change of the documents
+    void UpdateDocumentCount();
+
+    // Leaves the frozen and compressed modes before the index changes
+    void ThawIndex();
+
+    // Calls function(i) for i in [0, count): in order on the calling thread for the sequenced policy,
+    // on the executor otherwise
+    template <typename ExecutionPolicy, typename Function>
+    void RunFor(const ExecutionPolicy&, size_t count, Function function) const {
+        if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+            for (size_t i = 0; i < count; ++i) {
+                function(i);
+            }
+        }
+        else {
+            executor_->ParallelFor(count, function);
+        }
+    }
+
+    // Binary search in the forward index entry of a document, which is sorted by word
+    bool HasWord(const std::vector<WordFrequencies::Entry>& word_freqs, std::string_view word) const;
+
+    // Plus words of the query in the forward index entry, in query order, or none if it has a minus word
+    template <typename ExecutionPolicy>
+    std::vector<std::string_view> MatchWords(const ExecutionPolicy& policy, const Query& query, const std::vector<WordFrequencies::Entry>& word_freqs) const {
+        // Minus words first: one found makes the plus words irrelevant, and the remaining checks are skipped
+        std::atomic<bool> has_minus_word = false;
+        RunFor(policy, query.minus_words.size(), [this, &query, &word_freqs, &has_minus_word](size_t i) {
+            if (!has_minus_word.load(std::memory_order_relaxed) && HasWord(word_freqs, query.minus_words[i])) {
+                has_minus_word.store(true, std::memory_order_relaxed);
+            }
+            });
+        if (has_minus_word) {
+            return {};
+        }
+
+        // Every plus word owns its slot, so the workers write to disjoint memory. Query words are never empty,
+        // so the empty views of the unmatched words are then squeezed out in place, keeping the order
+        std::vector<std::string_view> matched_words(query.plus_words.size());
+        RunFor(policy, query.plus_words.size(), [this, &query, &word_freqs, &matched_words](size_t i) {
+            if (HasWord(word_freqs, query.plus_words[i])) {
+                matched_words[i] = query.plus_words[i];
+            }
+            });
+        matched_words.erase(std::remove(matched_words.begin(), matched_words.end(), std::string_view{}), matched_words.end());
+        return matched_words;
+    }
+
+    int AcquireOrdinal(int document_id, DocumentStatus status, int rating);
+
+    void ReleaseOrdinal(int ordinal);
+
+    // Drops the term from the dictionary once no document contains it
+    void EraseTermIfUnused(TermId term_id);
+
+    // Returns nullptr if no document contains the word
+    const PostingList* FindPostings(std::string_view word) const;
 
     bool IsStopWord(const std::string_view& word) const;
 
     static bool IsValidWord(std::string_view word);
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+    // Splits the text into words and drops the stop words; throws if some word is invalid
+    void SplitIntoWordsNoStop(std::string_view text, std::vector<std::string_view>& words) const;
 
-    static int ComputeAverageRating(const std::vector<int>& ratings);
+    // Term frequencies of the words of the text, sorted by word
+    using WordFreqs = std::vector<std::pair<std::string_view, double>>;
 
-    struct QueryWord {
-        std::string_view data;
-        bool is_minus;
-        bool is_stop;
+    struct TokenizedDocument {
+        WordFreqs word_freqs;
+        std::string error;
     };
 
-    QueryWord ParseQueryWord(const std::string_view text) const;
+    WordFreqs ComputeWordFreqs(std::string_view text) const;
 
-    struct Query {
-        std::set<std::string_view> plus_words;
-        std::set<std::string_view> minus_words;
-    };
+    void CheckNewDocumentIds(const std::vector<NewDocument>& documents) const;
 
-    Query ParseQuery(const std::string_view& text) const;
+    void IndexDocument(int document_id, DocumentStatus status, int rating, const WordFreqs& word_freqs);
 
-    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+    static int ComputeAverageRating(const std::vector<int>& ratings);
+
+    // Tokenizes the text into the words of the context and parses them into its query
+    void ParseQuery(std::string_view text, QueryContext& context) const;
+
+    // Plus words, then minus words with their '-', separated by spaces
+    static void WriteNormalizedText(const Query& query, std::string& text);
+
+    double ComputeWordInverseDocumentFreq(const PostingList& postings) const;
+
+    // Looks up the posting lists of the query words
+    void ResolveQuery(const Query& query, ResolvedQuery& resolved_query) const;
 
+    // Minus postings are listed rather than marked in a bitset while the range has this many times
+    // more ordinals than them. The list costs a seek per candidate, the bitset a pass over the range
+    static constexpr size_t SPARSE_EXCLUSION_RATIO = 64;
+
+    // Scores the documents with ordinals in [first_ordinal, last_ordinal) and pushes them to top_documents
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
-        std::map<int, double> document_to_relevance;
-        for (const std::string_view word : query.plus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
+    void FindDocumentsInRange(const ResolvedQuery& query, DocumentPredicate document_predicate,
+        int first_ordinal, int last_ordinal, TopDocuments& top_documents) const {
+        // Documents with minus words. Few of them are listed by ordinal, many are marked in a bitset
+        // by ordinal relative to first_ordinal, which takes a pass over the words of the range
+        const bool has_minus_postings = !query.minus_postings.empty();
+        size_t minus_posting_count = 0;
+        for (const PostingList* postings : query.minus_postings) {
+            minus_posting_count += postings->size();
+        }
+        const bool is_excluded_sparse = minus_posting_count * SPARSE_EXCLUSION_RATIO < static_cast<size_t>(last_ordinal - first_ordinal);
+        SparseDocumentSet& sparse_excluded = SparseDocumentSet::ForThisThread();
+        DocumentBitset& excluded = DocumentBitset::ForThisThread();
+        if (has_minus_postings && is_excluded_sparse) {
+            sparse_excluded.Clear();
+            for (const PostingList* postings : query.minus_postings) {
+                postings->ForEachInRange(first_ordinal, last_ordinal, [&sparse_excluded](int ordinal, double) {
+                    sparse_excluded.Insert(ordinal);
+                    });
             }
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
-                }
+            sparse_excluded.Seal();
+        }
+        else if (has_minus_postings) {
+            excluded.Assign(last_ordinal - first_ordinal);
+            for (const PostingList* postings : query.minus_postings) {
+                postings->ForEachInRange(first_ordinal, last_ordinal, [&excluded, first_ordinal](int ordinal, double) {
+                    excluded.Insert(ordinal - first_ordinal);
+                    });
             }
         }
 
-        for (const std::string_view word : query.minus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
+        // Both filters run before the document is scored
+        const auto is_allowed = [&](int ordinal) -> bool {
+            if (has_minus_postings && (is_excluded_sparse ? sparse_excluded.Contains(ordinal) : excluded.Contains(ordinal - first_ordinal))) {
+                return false;
+            }
+            if constexpr (std::is_same_v<DocumentPredicate, StatusPredicate>) {
+                return status_ordinals_[static_cast<size_t>(document_predicate.status)].Contains(ordinal);
             }
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                document_to_relevance.erase(document_id);
+            else {
+                return document_predicate(ordinal_to_document_id_[ordinal], ordinal_statuses_[ordinal], ordinal_ratings_[ordinal]);
             }
+        };
+
+        // Pruning skips through the lists by position, which compressed lists do not offer
+        if (query_mode_ == QueryMode::PRUNED && !is_index_compressed_) {
+            BlockMaxScorer::ForThisThread().Score(query.plus_postings, is_index_frozen_, first_ordinal, last_ordinal, is_allowed,
+                [this](int ordinal, double relevance) {
+                    return Document(ordinal_to_document_id_[ordinal], relevance, ordinal_ratings_[ordinal]);
+                }, top_documents);
+            return;
         }
 
-        std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance] : document_to_relevance) {
-            matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+        auto& document_to_relevance = RelevanceAccumulator::ForThisThread();
+        document_to_relevance.Reset(ordinal_to_document_id_.size());
+
+        const auto add_if_matches = [&](int ordinal, double relevance) {
+            if (is_allowed(ordinal)) {
+                document_to_relevance.Add(ordinal, relevance);
+            }
+        };
+        for (const auto& [postings, inverse_document_freq] : query.plus_postings) {
+            if (is_index_frozen_) {
+                postings->ForEachScoreInRange(first_ordinal, last_ordinal, add_if_matches);
+                continue;
+            }
+            postings->ForEachInRange(first_ordinal, last_ordinal, [&, inverse_document_freq = inverse_document_freq](int ordinal, double term_freq) {
+                add_if_matches(ordinal, term_freq * inverse_document_freq);
+                });
         }
-        return matched_documents;
+
+        CollectTopDocuments(document_to_relevance, top_documents);
+        document_to_relevance.Clear();
     }
 
+    void CollectTopDocuments(const RelevanceAccumulator& document_to_relevance, TopDocuments& top_documents) const;
+
+    template <typename DocumentPredicate>
+    void FindAllDocuments(const ResolvedQuery& query, DocumentPredicate document_predicate, TopDocuments& top_documents) const {
+        FindDocumentsInRange(query, document_predicate, 0, static_cast<int>(ordinal_to_document_id_.size()), top_documents);
+    }
+
+    // Most ordinals scored at once by FindTopDocumentsBatch; the batch accumulator holds this many scores
+    // per query, or one per ordinal on a smaller index, and the thread keeps it for its next batch
+    static constexpr int BATCH_WINDOW_SIZE = 4096;
+
+    // Queries visiting fewer postings are cheaper to run on the calling thread alone
+    static constexpr size_t PARALLEL_QUERY_MIN_POSTING_COUNT = 20'000;
+    // More parts than threads lets idle workers steal the remaining ranges
+    static constexpr size_t QUERY_PARTS_PER_THREAD = 4;
+
     template <typename ExecutionPolicy, typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(ExecutionPolicy policy, const Query& query, DocumentPredicate document_predicate) const {
-        if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
-            return FindAllDocuments(query, document_predicate);
+    void FindAllDocuments(ExecutionPolicy policy, const ResolvedQuery& resolved_query, DocumentPredicate document_predicate, TopDocuments& top_documents) const {
+        if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+            FindAllDocuments(resolved_query, document_predicate, top_documents);
         }
         else {
-            static constexpr int MINUS_LOCK_COUNT = 10;
-            ConcurrentMap<int, int> minus_ids(MINUS_LOCK_COUNT);
-            for_each(
-                policy,
-                query.minus_words.begin(),
-                query.minus_words.end(),
-                [this, &minus_ids](const std::string_view word) {
-                    if (word_to_document_freqs_.count(word)) {
-                        for (const auto& document_freqs : word_to_document_freqs_.at(word)) {
-                            minus_ids[document_freqs.first];
-                        }
-                    }
+            const int ordinal_count = static_cast<int>(ordinal_to_document_id_.size());
+            ThreadPool& pool = *executor_;
+            if (resolved_query.plus_posting_count < PARALLEL_QUERY_MIN_POSTING_COUNT) {
+                FindDocumentsInRange(resolved_query, document_predicate, 0, ordinal_count, top_documents);
+                return;
+            }
+
+            // Parts split the ordinal space, so each one scores its documents completely
+            // and only the per-part top documents have to be merged
+            const int part_count = static_cast<int>(std::min<size_t>(ordinal_count, (pool.GetThreadCount() + 1) * QUERY_PARTS_PER_THREAD));
+            std::vector<TopDocuments> part_top_documents(part_count, TopDocuments(top_documents.GetMaxCount()));
+            pool.ParallelFor(part_count, [&](size_t part) {
+                const int first_ordinal = static_cast<int>(int64_t{ ordinal_count } * part / part_count);
+                const int last_ordinal = static_cast<int>(int64_t{ ordinal_count } * (part + 1) / part_count);
+                FindDocumentsInRange(resolved_query, document_predicate, first_ordinal, last_ordinal, part_top_documents[part]);
+                });
+
+            for (TopDocuments& part : part_top_documents) {
+                for (const Document& document : part.Extract()) {
+                    top_documents.Push(document);
                 }
-            );
-
-            auto minus = minus_ids.BuildOrdinaryMap();
-
-            static constexpr int PLUS_LOCK_COUNT = 10000;
-            ConcurrentMap<int, double> document_to_relevance(PLUS_LOCK_COUNT);
-            static constexpr int PART_COUNT = 4;
-            const auto part_length = query.plus_words.size() / PART_COUNT;
-            auto part_begin = query.plus_words.begin();
-            auto part_end = next(part_begin, part_length);
-
-            std::vector<std::future<void>> futures;
-            for (int i = 0; i < PART_COUNT; ++i, part_begin = part_end, part_end = (i == PART_COUNT - 1 ? query.plus_words.end() : next(part_begin, part_length)))
-            {
-                futures.push_back(std::async([this, part_begin, part_end, document_predicate, &document_to_relevance, &minus]
-                    {
-                        for_each(part_begin, part_end, [this, document_predicate, &document_to_relevance, &minus](std::string_view word)
-                            {
-                                if (word_to_document_freqs_.count(word)) {
-                                    const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                                    //                        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                                    for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                                        const auto& document_data = documents_.at(document_id);
-                                        if (document_predicate(document_id, document_data.status, document_data.rating) &&
-                                            (minus.count(document_id) == 0)) {
-                                            document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-                                        }
-                                    }
-                                }
-
-                            });
-                    }));
-            }
-
-            for (auto& f : futures) {
-                f.get();
-            }
-
-            std::vector<Document> matched_documents;
-            for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) {
-                matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
-            }
-            return matched_documents;
+            }
         }
     }
 
@@ -0,0 +1,169 @@
+#include "segmented_search_server.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+SegmentedSearchServer::SegmentedSearchServer(const std::string& stop_words_text, size_t max_mutable_document_count)
+    : SegmentedSearchServer(make_shared<const SearchServer>(stop_words_text), max_mutable_document_count)
+{
+}
+
+SegmentedSearchServer::SegmentedSearchServer(std::string_view stop_words_text, size_t max_mutable_document_count)
+    : SegmentedSearchServer(make_shared<const SearchServer>(stop_words_text), max_mutable_document_count)
+{
+}
+
+SegmentedSearchServer::SegmentedSearchServer(std::shared_ptr<const SearchServer> empty_index, size_t max_mutable_document_count)
+    : empty_index_(move(empty_index))
+    , max_mutable_document_count_(max_mutable_document_count)
+    , merge_policy_(max_mutable_document_count)
+    , mutable_index_(make_shared<SearchServer>(*empty_index_))
+    , mutable_segment_(make_shared<IndexSegment>(IndexSegment{ mutable_index_ }))
+{
+    merger_ = thread([this] {
+        MergeLoop();
+        });
+}
+
+SegmentedSearchServer::~SegmentedSearchServer() {
+    {
+        lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    merge_needed_.notify_all();
+    merger_.join();
+}
+
+void SegmentedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    if (document_id < 0) {
+        throw invalid_argument("Invalid document_id"s);
+    }
+    // Tokenized before taking the lock, so that queries are not held up by it
+    const SearchServer::WordFreqs word_freqs = empty_index_->ComputeWordFreqs(document);
+    const int rating = SearchServer::ComputeAverageRating(ratings);
+
+    unique_lock lock(mutex_);
+    if (!documents_.emplace(document_id, mutable_segment_.get()).second) {
+        throw invalid_argument("Invalid document_id"s);
+    }
+    mutable_index_->IndexDocument(document_id, status, rating, word_freqs);
+    if (static_cast<size_t>(mutable_index_->GetDocumentCount()) >= max_mutable_document_count_) {
+        SealMutableSegment();
+    }
+}
+
+void SegmentedSearchServer::RemoveDocument(int document_id) {
+    unique_lock lock(mutex_);
+    const auto location = documents_.find(document_id);
+    if (location == documents_.end()) {
+        return;
+    }
+    IndexSegment* const segment = location->second;
+    documents_.erase(location);
+    if (segment == mutable_segment_.get()) {
+        mutable_index_->RemoveDocument(document_id);
+        return;
+    }
+    segment->MarkRemoved(document_id);
+    if (merge_policy_.NeedsRewrite(*segment)) {
+        merge_needed_.notify_one();
+    }
+}
+
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(execution::seq, raw_query, status);
+}
+
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SegmentedSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    shared_lock lock(mutex_);
+    const auto location = documents_.find(document_id);
+    // The empty index still validates the query
+    const SearchServer& index = location == documents_.end() ? *empty_index_ : *location->second->index;
+    return index.MatchDocument(raw_query, document_id);
+}
+
+int SegmentedSearchServer::GetDocumentCount() const {
+    shared_lock lock(mutex_);
+    return static_cast<int>(documents_.size());
+}
+
+size_t SegmentedSearchServer::GetSegmentCount() const {
+    shared_lock lock(mutex_);
+    return segments_.size();
+}
+
+void SegmentedSearchServer::Flush() {
+    unique_lock lock(mutex_);
+    SealMutableSegment();
+    merges_done_.wait(lock, [this] {
+        return !is_merging_ && merge_policy_.PickSegmentsToMerge(segments_).empty();
+        });
+}
+
+void SegmentedSearchServer::SealMutableSegment() {
+    if (mutable_index_->GetDocumentCount() == 0) {
+        return;
+    }
+    // Locations keep pointing to the same segment object, which only changes hands
+    segments_.push_back(move(mutable_segment_));
+    mutable_index_ = make_shared<SearchServer>(*empty_index_);
+    mutable_segment_ = make_shared<IndexSegment>(IndexSegment{ mutable_index_ });
+    merge_needed_.notify_one();
+}
+
+void SegmentedSearchServer::MergeLoop() {
+    unique_lock lock(mutex_);
+    while (true) {
+        merge_needed_.wait(lock, [this] {
+            return stopping_ || !merge_policy_.PickSegmentsToMerge(segments_).empty();
+            });
+        if (stopping_) {
+            return;
+        }
+        is_merging_ = true;
+        Merge(merge_policy_.PickSegmentsToMerge(segments_), lock);
+        is_merging_ = false;
+        merges_done_.notify_all();
+    }
+}
+
+void SegmentedSearchServer::Merge(const std::vector<std::shared_ptr<IndexSegment>>& sources, std::unique_lock<std::shared_mutex>& lock) {
+    // Indexes of sealed segments never change, so the new segment is built without the lock
+    // from copies of the tombstones taken under it
+    vector<shared_ptr<const IndexSegment>> snapshots;
+    snapshots.reserve(sources.size());
+    for (const auto& source : sources) {
+        snapshots.push_back(make_shared<const IndexSegment>(*source));
+    }
+    lock.unlock();
+    const shared_ptr<IndexSegment> merged = IndexSegment::Merge(*empty_index_, snapshots);
+    lock.lock();
+
+    // Documents removed during the merge are carried over as tombstones. One added again
+    // meanwhile lives in the mutable segment, so it is not located in a source
+    for (const int document_id : *merged->index) {
+        const auto location = documents_.find(document_id);
+        const bool is_live = location != documents_.end() && any_of(sources.begin(), sources.end(), [&location](const shared_ptr<IndexSegment>& source) {
+            return source.get() == location->second;
+            });
+        if (is_live) {
+            location->second = merged.get();
+        }
+        else {
+            merged->MarkRemoved(document_id);
+        }
+    }
+
+    segments_.erase(remove_if(segments_.begin(), segments_.end(), [&sources](const shared_ptr<IndexSegment>& segment) {
+        return find(sources.begin(), sources.end(), segment) != sources.end();
+        }), segments_.end());
+    if (merged->GetDocumentCount() > 0) {
+        segments_.push_back(merged);
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <condition_variable>
+#include <execution>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+#include "index_segment.h"
+#include "search_server.h"
+#include "top_documents.h"
+
+// Search server whose index is a set of segments, in the manner of an LSM tree.
+// New documents go to a small mutable segment that is sealed once it holds
+// max_mutable_document_count documents. Sealed segments never change except for
+// tombstones set by RemoveDocument. A background thread merges segments picked by
+// TieredMergePolicy, dropping removed documents for good. Segments are the IndexSegments
+// of SnapshotSearchServer, so queries give the same results as a single SearchServer
+class SegmentedSearchServer {
+public:
+
+    template <typename StringContainer>
+    explicit SegmentedSearchServer(const StringContainer& stop_words, size_t max_mutable_document_count = DEFAULT_MAX_MUTABLE_DOCUMENT_COUNT)
+        : SegmentedSearchServer(std::make_shared<const SearchServer>(stop_words), max_mutable_document_count)
+    {
+    }
+
+    explicit SegmentedSearchServer(const std::string& stop_words_text, size_t max_mutable_document_count = DEFAULT_MAX_MUTABLE_DOCUMENT_COUNT);
+
+    explicit SegmentedSearchServer(std::string_view stop_words_text, size_t max_mutable_document_count = DEFAULT_MAX_MUTABLE_DOCUMENT_COUNT);
+
+    SegmentedSearchServer(const SegmentedSearchServer&) = delete;
+    SegmentedSearchServer& operator=(const SegmentedSearchServer&) = delete;
+
+    ~SegmentedSearchServer();
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    void RemoveDocument(int document_id);
+
+    // Segments are searched one after another; the parallel policy splits the search of each one
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        SegmentQuery query(*empty_index_, raw_query);
+
+        std::shared_lock lock(mutex_);
+        for (const auto& segment : segments_) {
+            query.CountDocumentFreqs(*segment);
+        }
+        query.CountDocumentFreqs(*mutable_segment_);
+        query.SetDocumentCount(static_cast<int>(documents_.size()));
+
+        TopDocuments top_documents(max_count);
+        for (const auto& segment : segments_) {
+            query.FindDocuments(policy, *segment, document_predicate, top_documents);
+        }
+        query.FindDocuments(policy, *mutable_segment_, document_predicate, top_documents);
+        return top_documents.Extract();
+    }
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentStatus status) const {
+        return FindTopDocuments(policy, raw_query, SearchServer::StatusPredicate{ status });
+    }
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query) const {
+        return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+    }
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_count);
+    }
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+
+    // Sealed segments, not counting the mutable one
+    size_t GetSegmentCount() const;
+
+    // Seals the mutable segment and blocks until no merge is pending
+    void Flush();
+
+private:
+    static constexpr size_t DEFAULT_MAX_MUTABLE_DOCUMENT_COUNT = 1024;
+
+    // Parses queries and tokenizes documents; segments are built on copies of it,
+    // so that they share its stop words and executor
+    const std::shared_ptr<const SearchServer> empty_index_;
+    const size_t max_mutable_document_count_;
+    const TieredMergePolicy merge_policy_;
+
+    // Guards everything below except the indexes of sealed segments, which never change
+    mutable std::shared_mutex mutex_;
+    std::vector<std::shared_ptr<IndexSegment>> segments_;
+    // The index of the mutable segment, which documents are added to and removed from in place
+    std::shared_ptr<SearchServer> mutable_index_;
+    std::shared_ptr<IndexSegment> mutable_segment_;
+    // Segment holding every live document
+    std::unordered_map<int, IndexSegment*> documents_;
+
+    std::thread merger_;
+    std::condition_variable_any merge_needed_;
+    std::condition_variable_any merges_done_;
+    bool is_merging_ = false;
+    bool stopping_ = false;
+
+    SegmentedSearchServer(std::shared_ptr<const SearchServer> empty_index, size_t max_mutable_document_count);
+
+    // Called with the lock held
+    void SealMutableSegment();
+
+    void MergeLoop();
+
+    void Merge(const std::vector<std::shared_ptr<IndexSegment>>& sources, std::unique_lock<std::shared_mutex>& lock);
+};
@@ -0,0 +1,165 @@
+#include "snapshot_search_server.h"
+
+#include <algorithm>
+
+using namespace std;
+
+std::vector<Document> SnapshotSearchServer::Snapshot::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(execution::seq, raw_query, status);
+}
+
+std::vector<Document> SnapshotSearchServer::Snapshot::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SnapshotSearchServer::Snapshot::MatchDocument(std::string_view raw_query, int document_id) const {
+    // A document removed from an older segment may have been added again to a newer one
+    for (auto segment = segments_.rbegin(); segment != segments_.rend(); ++segment) {
+        if ((*segment)->FindOrdinal(document_id) != -1) {
+            return (*segment)->index->MatchDocument(raw_query, document_id);
+        }
+    }
+    // Still validates the query
+    return parser_->MatchDocument(raw_query, document_id);
+}
+
+int SnapshotSearchServer::Snapshot::GetDocumentCount() const {
+    return document_count_;
+}
+
+size_t SnapshotSearchServer::Snapshot::GetSegmentCount() const {
+    return segments_.size();
+}
+
+SnapshotSearchServer::SnapshotSearchServer(const std::string& stop_words_text)
+    : SnapshotSearchServer(make_shared<const SearchServer>(stop_words_text))
+{
+}
+
+SnapshotSearchServer::SnapshotSearchServer(std::string_view stop_words_text)
+    : SnapshotSearchServer(make_shared<const SearchServer>(stop_words_text))
+{
+}
+
+SnapshotSearchServer::SnapshotSearchServer(std::shared_ptr<const SearchServer> empty_index)
+    : empty_index_(move(empty_index))
+{
+    auto snapshot = make_shared<Snapshot>();
+    snapshot->parser_ = empty_index_;
+    current_ = move(snapshot);
+}
+
+std::shared_ptr<const SnapshotSearchServer::Snapshot> SnapshotSearchServer::GetSnapshot() const {
+    return atomic_load(&current_);
+}
+
+uint64_t SnapshotSearchServer::GetGeneration() const {
+    return generation_;
+}
+
+void SnapshotSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    lock_guard guard(writer_mutex_);
+    staged_.push_back(AddOperation{ document_id, string(document), status, ratings });
+}
+
+void SnapshotSearchServer::RemoveDocument(int document_id) {
+    lock_guard guard(writer_mutex_);
+    staged_.push_back(RemoveOperation{ document_id });
+}
+
+void SnapshotSearchServer::Commit() {
+    lock_guard guard(writer_mutex_);
+    if (staged_.empty()) {
+        return;
+    }
+    auto staged = move(staged_);
+    staged_.clear();
+
+    // Only writers get here, and they are serialized, so the current generation cannot change meanwhile.
+    // The sealed segments are shared with it until this commit gives them tombstones
+    const shared_ptr<const Snapshot> current = atomic_load(&current_);
+    vector<shared_ptr<const IndexSegment>> segments = current->segments_;
+    shared_ptr<SearchServer> open_index;
+    if (!segments.empty() && segments.back()->removed_ordinals.empty()
+        && segments.back()->index->GetDocumentCount() < OPEN_SEGMENT_DOCUMENT_COUNT) {
+        open_index = make_shared<SearchServer>(*segments.back()->index);
+        segments.pop_back();
+    }
+    else {
+        open_index = make_shared<SearchServer>(*empty_index_);
+    }
+    // Copies of the segments that got tombstones in this commit, by position in segments
+    vector<shared_ptr<IndexSegment>> changed_segments(segments.size());
+
+    // Position of the sealed segment holding the live document, segments.size() if there is none
+    const auto find_sealed = [&segments](int document_id) {
+        for (size_t i = segments.size(); i-- > 0;) {
+            if (segments[i]->FindOrdinal(document_id) != -1) {
+                return i;
+            }
+        }
+        return segments.size();
+    };
+
+    for (const auto& operation : staged) {
+        if (const auto* add = get_if<AddOperation>(&operation)) {
+            if (find_sealed(add->document_id) != segments.size()) {
+                throw invalid_argument("Invalid document_id"s);
+            }
+            open_index->AddDocument(add->document_id, add->document, add->status, add->ratings);
+            if (open_index->GetDocumentCount() >= OPEN_SEGMENT_DOCUMENT_COUNT) {
+                segments.push_back(make_shared<const IndexSegment>(IndexSegment{ move(open_index) }));
+                changed_segments.emplace_back();
+                open_index = make_shared<SearchServer>(*empty_index_);
+            }
+            continue;
+        }
+
+        const int document_id = get<RemoveOperation>(operation).document_id;
+        if (IndexSegment::FindOrdinal(*open_index, document_id) != -1) {
+            open_index->RemoveDocument(document_id);
+            continue;
+        }
+        const size_t position = find_sealed(document_id);
+        if (position == segments.size()) {
+            continue;
+        }
+        if (!changed_segments[position]) {
+            changed_segments[position] = make_shared<IndexSegment>(*segments[position]);
+            segments[position] = changed_segments[position];
+        }
+        changed_segments[position]->MarkRemoved(document_id);
+    }
+
+    CompactSegments(segments);
+    if (open_index->GetDocumentCount() > 0) {
+        segments.push_back(make_shared<const IndexSegment>(IndexSegment{ move(open_index) }));
+    }
+
+    auto next = make_shared<Snapshot>();
+    next->parser_ = empty_index_;
+    next->segments_ = move(segments);
+    for (const auto& segment : next->segments_) {
+        next->document_count_ += segment->GetDocumentCount();
+    }
+
+    atomic_store(&current_, shared_ptr<const Snapshot>(move(next)));
+    ++generation_;
+}
+
+void SnapshotSearchServer::CompactSegments(std::vector<std::shared_ptr<const IndexSegment>>& segments) const {
+    while (true) {
+        const auto sources = merge_policy_.PickSegmentsToMerge(segments);
+        if (sources.empty()) {
+            return;
+        }
+
+        shared_ptr<const IndexSegment> merged = IndexSegment::Merge(*empty_index_, sources);
+        segments.erase(remove_if(segments.begin(), segments.end(), [&sources](const shared_ptr<const IndexSegment>& segment) {
+            return find(sources.begin(), sources.end(), segment) != sources.end();
+            }), segments.end());
+        if (merged->GetDocumentCount() > 0) {
+            segments.push_back(move(merged));
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <execution>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#include "index_segment.h"
+#include "search_server.h"
+#include "top_documents.h"
+
+// SearchServer that keeps serving queries while documents are added and removed.
+// Readers take a snapshot: a shared reference to an immutable index generation.
+// A generation is a list of immutable segments, each a SearchServer with the ordinals of
+// its removed documents. Writers stage changes, and Commit builds the next generation
+// from the current one: new documents go to a copy of the small open segment, removals
+// of older documents become tombstones, and every other segment is shared. Segments are
+// merged by TieredMergePolicy, as in SegmentedSearchServer. A generation is freed when
+// its last snapshot is released
+class SnapshotSearchServer {
+public:
+
+    // Immutable index generation
+    class Snapshot {
+    public:
+        template <typename ExecutionPolicy, typename DocumentPredicate>
+        std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+            SegmentQuery query(*parser_, raw_query);
+            for (const auto& segment : segments_) {
+                query.CountDocumentFreqs(*segment);
+            }
+            query.SetDocumentCount(document_count_);
+
+            TopDocuments top_documents(MAX_RESULT_DOCUMENT_COUNT);
+            for (const auto& segment : segments_) {
+                query.FindDocuments(policy, *segment, document_predicate, top_documents);
+            }
+            return top_documents.Extract();
+        }
+
+        template <typename ExecutionPolicy>
+        std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentStatus status) const {
+            return FindTopDocuments(policy, raw_query, SearchServer::StatusPredicate{ status });
+        }
+
+        template <typename ExecutionPolicy>
+        std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query) const {
+            return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+        }
+
+        template <typename DocumentPredicate>
+        std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+            return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+        }
+
+        std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+
+        std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+        std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+        int GetDocumentCount() const;
+
+        size_t GetSegmentCount() const;
+
+    private:
+        friend class SnapshotSearchServer;
+
+        // Empty server with the stop words, which parses queries
+        std::shared_ptr<const SearchServer> parser_;
+        // Oldest first; the last one is open to new documents while it is small
+        std::vector<std::shared_ptr<const IndexSegment>> segments_;
+        int document_count_ = 0;
+    };
+
+    template <typename StringContainer>
+    explicit SnapshotSearchServer(const StringContainer& stop_words)
+        : SnapshotSearchServer(std::make_shared<const SearchServer>(stop_words))
+    {
+    }
+
+    explicit SnapshotSearchServer(const std::string& stop_words_text);
+
+    explicit SnapshotSearchServer(std::string_view stop_words_text);
+
+    // Cheap to take and safe to use from any thread while writers commit
+    std::shared_ptr<const Snapshot> GetSnapshot() const;
+
+    // Number of generations published so far
+    uint64_t GetGeneration() const;
+
+    // Staged until the next Commit
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    // Staged until the next Commit
+    void RemoveDocument(int document_id);
+
+    // Applies the staged changes in order and publishes the result as a new generation.
+    // If a change is invalid, nothing is published, the staged changes are dropped and the error is rethrown
+    void Commit();
+
+private:
+    // The open segment is sealed at this size, which bounds the copy made by every commit
+    static constexpr int OPEN_SEGMENT_DOCUMENT_COUNT = 1024;
+    const TieredMergePolicy merge_policy_{ OPEN_SEGMENT_DOCUMENT_COUNT };
+
+    struct AddOperation {
+        int document_id;
+        std::string document;
+        DocumentStatus status;
+        std::vector<int> ratings;
+    };
+
+    struct RemoveOperation {
+        int document_id;
+    };
+
+    // Generations are built on copies of it, so that they share its stop words and executor
+    const std::shared_ptr<const SearchServer> empty_index_;
+
+    // Guarded with std::atomic_load and std::atomic_store
+    std::shared_ptr<const Snapshot> current_;
+    std::atomic<uint64_t> generation_ = 0;
+
+    std::mutex writer_mutex_;
+    std::vector<std::variant<AddOperation, RemoveOperation>> staged_;
+
+    explicit SnapshotSearchServer(std::shared_ptr<const SearchServer> empty_index);
+
+    // Rewrites the segments with too many tombstones and merges full tiers
+    void CompactSegments(std::vector<std::shared_ptr<const IndexSegment>>& segments) const;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+// Set of document ordinals as a sorted array, for sets much smaller than the range of their
+// ordinals: building one costs its size rather than a pass over the range as with DocumentBitset.
+// Lookups seek forward from the previous one, so a run of lookups in ascending order merges
+// with the array; a lookup below the previous one searches it from the start
+class SparseDocumentSet {
+public:
+
+    // Makes the set empty and keeps the capacity
+    void Clear() {
+        ordinals_.clear();
+        cursor_ = 0;
+    }
+
+    // Insertions can come in any order, and have to be followed by Seal before lookups
+    void Insert(int ordinal) {
+        ordinals_.push_back(ordinal);
+    }
+
+    void Seal() {
+        std::sort(ordinals_.begin(), ordinals_.end());
+        ordinals_.erase(std::unique(ordinals_.begin(), ordinals_.end()), ordinals_.end());
+        cursor_ = 0;
+    }
+
+    // Not const: moves the cursor
+    bool Contains(int ordinal) {
+        if (cursor_ > 0 && ordinals_[cursor_ - 1] >= ordinal) {
+            cursor_ = 0;
+        }
+        cursor_ = std::lower_bound(ordinals_.begin() + cursor_, ordinals_.end(), ordinal) - ordinals_.begin();
+        return cursor_ < ordinals_.size() && ordinals_[cursor_] == ordinal;
+    }
+
+    size_t size() const {
+        return ordinals_.size();
+    }
+
+    // Scratch instance owned by the calling thread
+    static SparseDocumentSet& ForThisThread() {
+        static thread_local SparseDocumentSet set;
+        return set;
+    }
+
+private:
+    std::vector<int> ordinals_;
+    // Every ordinal before it is less than the last ordinal looked up
+    size_t cursor_ = 0;
+};
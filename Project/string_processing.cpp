@@ -1,19 +1,131 @@
 #include "string_processing.h"
 
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define SEARCH_SERVER_HAS_SSE2
+#if defined(__GNUC__)
+#define SEARCH_SERVER_HAS_AVX2
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 using namespace std;
 
-vector<string_view> SplitIntoWords(string_view text) {
-    std::vector<std::string_view> result;
-    const int64_t pos_end = text.npos;
-    while (true) {
-        int64_t space = text.find(' ');
-        result.push_back(space == pos_end ? text.substr(0) : text.substr(0, space));
-        if (space == pos_end) {
-            break;
+namespace {
+
+bool IsControlCharacter(char c) {
+    return c >= '\0' && c < ' ';
+}
+
+int CountTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// Appends the words that end at the spaces flagged in space_mask, bit i standing for text[offset + i]
+void AddWordsEndingAt(string_view text, size_t offset, uint32_t space_mask, size_t& word_begin, vector<string_view>& words) {
+    while (space_mask != 0) {
+        const size_t space = offset + CountTrailingZeros(space_mask);
+        words.push_back(text.substr(word_begin, space - word_begin));
+        word_begin = space + 1;
+        space_mask &= space_mask - 1;
+    }
+}
+
+// Every scanner handles the longest prefix of the text it can, starting from pos, and returns where it stopped.
+// Words ending inside that prefix are added, the current word starts at word_begin,
+// and has_control is set if the prefix contains a control character
+size_t ScanScalar(string_view text, size_t pos, size_t& word_begin, vector<string_view>& words, bool& has_control) {
+    for (; pos < text.size(); ++pos) {
+        if (text[pos] == ' ') {
+            words.push_back(text.substr(word_begin, pos - word_begin));
+            word_begin = pos + 1;
         }
-        else {
-            text.remove_prefix(space + 1);
+        else if (IsControlCharacter(text[pos])) {
+            has_control = true;
         }
     }
+    return pos;
+}
+
+#ifdef SEARCH_SERVER_HAS_SSE2
+size_t ScanSse2(string_view text, size_t pos, size_t& word_begin, vector<string_view>& words, bool& has_control) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i last_control = _mm_set1_epi8(' ' - 1);
+    __m128i control = _mm_setzero_si128();
+    for (; pos + 16 <= text.size(); pos += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + pos));
+        // Bytes not above 31 as unsigned are exactly the control characters
+        control = _mm_or_si128(control, _mm_cmpeq_epi8(_mm_min_epu8(block, last_control), block));
+        const uint32_t space_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, space)));
+        AddWordsEndingAt(text, pos, space_mask, word_begin, words);
+    }
+    has_control |= _mm_movemask_epi8(control) != 0;
+    return pos;
+}
+#endif
+
+#ifdef SEARCH_SERVER_HAS_AVX2
+__attribute__((target("avx2")))
+size_t ScanAvx2(string_view text, size_t pos, size_t& word_begin, vector<string_view>& words, bool& has_control) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i last_control = _mm256_set1_epi8(' ' - 1);
+    __m256i control = _mm256_setzero_si256();
+    for (; pos + 32 <= text.size(); pos += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + pos));
+        control = _mm256_or_si256(control, _mm256_cmpeq_epi8(_mm256_min_epu8(block, last_control), block));
+        const uint32_t space_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, space)));
+        AddWordsEndingAt(text, pos, space_mask, word_begin, words);
+    }
+    has_control |= _mm256_movemask_epi8(control) != 0;
+    return pos;
+}
+#endif
+
+using Scanner = size_t (*)(string_view, size_t, size_t&, vector<string_view>&, bool&);
+
+// The widest scanner the processor supports, chosen once
+Scanner GetBlockScanner() {
+#if defined(SEARCH_SERVER_HAS_AVX2)
+    static const Scanner scanner = __builtin_cpu_supports("avx2") ? ScanAvx2 : ScanSse2;
+    return scanner;
+#elif defined(SEARCH_SERVER_HAS_SSE2)
+    return ScanSse2;
+#else
+    return ScanScalar;
+#endif
+}
+
+} // namespace
+
+vector<string_view> SplitIntoWords(string_view text) {
+    vector<string_view> result;
+    SplitIntoValidWords(text, result);
     return result;
-}
\ No newline at end of file
+}
+
+bool SplitIntoValidWords(string_view text, vector<string_view>& words) {
+    words.clear();
+    size_t word_begin = 0;
+    bool has_control = false;
+    size_t pos = GetBlockScanner()(text, 0, word_begin, words, has_control);
+    // The tail shorter than a block
+    ScanScalar(text, pos, word_begin, words, has_control);
+    words.push_back(text.substr(word_begin));
+    return !has_control;
+}
+
+bool IsValidWord(string_view word) {
+    return none_of(word.begin(), word.end(), IsControlCharacter);
+}
@@ -1,11 +1,67 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <set>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
+// Splits the text at every space; consecutive spaces give empty words
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
+// Same split as SplitIntoWords into a buffer the caller reuses: words is cleared, but keeps its capacity.
+// Spaces and control characters are found in one vectorized pass over the text;
+// returns false if any word is not valid
+bool SplitIntoValidWords(std::string_view text, std::vector<std::string_view>& words);
+
+// A valid word must not contain special characters
+bool IsValidWord(std::string_view word);
+
+// Words of a parsed query, viewing the query text
+struct QueryWords {
+    // Sorted and without duplicates
+    std::vector<std::string_view> plus_words;
+    std::vector<std::string_view> minus_words;
+};
+
+// Splits a query into its plus and minus words and drops the words is_stop_word accepts.
+// words is a buffer the caller reuses, as in SplitIntoValidWords, and so are the vectors of query.
+// Throws std::invalid_argument if a word is invalid, empty or starts with a double minus
+template <typename StopWordPredicate>
+void ParseQueryWords(std::string_view text, StopWordPredicate is_stop_word, std::vector<std::string_view>& words, QueryWords& query) {
+    if (!SplitIntoValidWords(text, words)) {
+        std::string_view word = *std::find_if_not(words.begin(), words.end(), IsValidWord);
+        if (word[0] == '-') {
+            word.remove_prefix(1);
+        }
+        throw std::invalid_argument("Query word " + std::string(word) + " is invalid");
+    }
+
+    query.plus_words.clear();
+    query.minus_words.clear();
+    for (std::string_view word : words) {
+        if (word.empty()) {
+            throw std::invalid_argument("Query word is empty");
+        }
+        const bool is_minus = word[0] == '-';
+        if (is_minus) {
+            word.remove_prefix(1);
+        }
+        if (word.empty() || word[0] == '-') {
+            throw std::invalid_argument("Query word " + std::string(word) + " is invalid");
+        }
+        if (is_stop_word(word)) {
+            continue;
+        }
+        (is_minus ? query.minus_words : query.plus_words).push_back(word);
+    }
+    for (auto* query_words : { &query.plus_words, &query.minus_words }) {
+        std::sort(query_words->begin(), query_words->end());
+        query_words->erase(std::unique(query_words->begin(), query_words->end()), query_words->end());
+    }
+}
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
     std::set<std::string, std::less<>> non_empty_strings;
@@ -0,0 +1,113 @@
+#include "term_dictionary.h"
+
+#include <algorithm>
+
+std::string_view StringArena::Store(std::string_view text) {
+    if (text.size() > free_size_) {
+        // A string longer than a block gets a block of its own
+        const size_t size = std::max(block_size_, text.size());
+        blocks_.push_back(std::make_unique<char[]>(size));
+        free_begin_ = blocks_.back().get();
+        free_size_ = size;
+        reserved_ += size;
+    }
+    char* const stored = free_begin_;
+    std::copy(text.begin(), text.end(), stored);
+    free_begin_ += text.size();
+    free_size_ -= text.size();
+    return { stored, text.size() };
+}
+
+TermDictionary::TermDictionary(const TermDictionary& other)
+    : free_ids_(other.free_ids_)
+    , live_bytes_(other.live_bytes_)
+{
+    terms_.reserve(other.terms_.size());
+    term_to_id_.reserve(other.term_to_id_.size());
+    for (TermId term_id = 0; term_id < other.terms_.size(); ++term_id) {
+        const auto it = other.term_to_id_.find(other.terms_[term_id]);
+        if (it == other.term_to_id_.end() || it->second != term_id) {
+            // The id is in free_ids_
+            terms_.push_back({});
+            continue;
+        }
+        terms_.push_back(arena_.Store(other.terms_[term_id]));
+        term_to_id_.emplace(terms_.back(), term_id);
+    }
+}
+
+TermDictionary& TermDictionary::operator=(const TermDictionary& other) {
+    if (this != &other) {
+        TermDictionary copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+TermId TermDictionary::Intern(std::string_view term) {
+    const auto it = term_to_id_.find(term);
+    if (it != term_to_id_.end()) {
+        return it->second;
+    }
+
+    std::string_view stored_term;
+    if (auto erased_term = erased_terms_.extract(term)) {
+        stored_term = erased_term.value();
+        dead_bytes_ -= stored_term.size();
+    }
+    else {
+        stored_term = arena_.Store(term);
+    }
+    live_bytes_ += stored_term.size();
+    TermId term_id;
+    if (free_ids_.empty()) {
+        term_id = static_cast<TermId>(terms_.size());
+        terms_.push_back(stored_term);
+    }
+    else {
+        term_id = free_ids_.back();
+        free_ids_.pop_back();
+        terms_[term_id] = stored_term;
+    }
+    term_to_id_.emplace(stored_term, term_id);
+    return term_id;
+}
+
+void TermDictionary::Erase(TermId term_id) {
+    const std::string_view term = terms_[term_id];
+    term_to_id_.erase(term);
+    terms_[term_id] = {};
+    free_ids_.push_back(term_id);
+    live_bytes_ -= term.size();
+    dead_bytes_ += term.size();
+    erased_terms_.insert(term);
+    if (dead_bytes_ > std::max(live_bytes_, MIN_COMPACTION_BYTES)) {
+        Compact();
+    }
+}
+
+void TermDictionary::Compact() {
+    StringArena arena;
+    std::unordered_map<std::string_view, TermId> term_to_id;
+    term_to_id.reserve(term_to_id_.size());
+    for (const auto& [term, term_id] : term_to_id_) {
+        terms_[term_id] = arena.Store(term);
+        term_to_id.emplace(terms_[term_id], term_id);
+    }
+    arena_ = std::move(arena);
+    term_to_id_ = std::move(term_to_id);
+    erased_terms_.clear();
+    dead_bytes_ = 0;
+}
+
+size_t TermDictionary::GetMemoryUsage() const {
+    // A hash node holds the next pointer, the key, the id and the cached hash
+    const size_t node_size = sizeof(void*) + sizeof(std::string_view) + sizeof(TermId) + sizeof(size_t);
+    return arena_.GetMemoryUsage()
+        + term_to_id_.bucket_count() * sizeof(void*)
+        + term_to_id_.size() * node_size
+        + terms_.capacity() * sizeof(std::string_view)
+        + free_ids_.capacity() * sizeof(TermId)
+        + erased_terms_.bucket_count() * sizeof(void*)
+        + erased_terms_.size() * (sizeof(void*) + sizeof(std::string_view) + sizeof(size_t));
+}
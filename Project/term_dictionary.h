@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using TermId = uint32_t;
+
+// Append-only storage for string bytes. Stored strings never move,
+// so views into the arena stay valid for the arena's lifetime
+class StringArena {
+public:
+
+    explicit StringArena(size_t block_size = 64 * 1024)
+        : block_size_(block_size) {
+    }
+
+    std::string_view Store(std::string_view text);
+
+    // Bytes reserved from the system, including unused block tails
+    size_t GetMemoryUsage() const {
+        return reserved_;
+    }
+
+private:
+    size_t block_size_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* free_begin_ = nullptr;
+    size_t free_size_ = 0;
+    size_t reserved_ = 0;
+};
+
+// Maps every distinct term to a compact 32-bit id. Term bytes live in a StringArena,
+// and the lookup table is keyed by views into it, so a lookup never builds a std::string.
+// Ids of erased terms are reused. The bytes of an erased term stay in the arena and are taken
+// back if the same term is interned again; once the dead bytes outgrow the live ones, Erase moves
+// the live terms to a fresh arena, so views from GetTerm are valid only until the next Erase
+class TermDictionary {
+public:
+    static constexpr TermId NO_TERM = std::numeric_limits<TermId>::max();
+
+    TermDictionary() = default;
+
+    // The copy stores its terms in an arena of its own and keeps every id
+    TermDictionary(const TermDictionary& other);
+    TermDictionary& operator=(const TermDictionary& other);
+
+    TermDictionary(TermDictionary&&) = default;
+    TermDictionary& operator=(TermDictionary&&) = default;
+
+    // Returns the id of the term, adding the term if needed
+    TermId Intern(std::string_view term);
+
+    // Returns NO_TERM for an unknown term
+    TermId Find(std::string_view term) const {
+        const auto it = term_to_id_.find(term);
+        return it == term_to_id_.end() ? NO_TERM : it->second;
+    }
+
+    std::string_view GetTerm(TermId term_id) const {
+        return terms_[term_id];
+    }
+
+    void Erase(TermId term_id);
+
+    // Upper bound of the ids handed out so far
+    size_t GetIdLimit() const {
+        return terms_.size();
+    }
+
+    size_t size() const {
+        return term_to_id_.size();
+    }
+
+    // Includes the dead bytes
+    size_t GetMemoryUsage() const;
+
+    // Arena bytes of erased terms not reclaimed yet
+    size_t GetDeadBytes() const {
+        return dead_bytes_;
+    }
+
+private:
+    // Dead bytes below this are never worth a compaction
+    static constexpr size_t MIN_COMPACTION_BYTES = 64 * 1024;
+
+    StringArena arena_;
+    std::unordered_map<std::string_view, TermId> term_to_id_;
+    std::vector<std::string_view> terms_;
+    std::vector<TermId> free_ids_;
+    // Stored bytes of erased terms, which a term interned again reuses
+    std::unordered_set<std::string_view> erased_terms_;
+    size_t live_bytes_ = 0;
+    size_t dead_bytes_ = 0;
+
+    // Moves the live terms to a fresh arena and drops the dead bytes
+    void Compact();
+};
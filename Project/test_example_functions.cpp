@@ -1 +1,995 @@
-#include "test_example_functions.h"
\ No newline at end of file
+#include "test_example_functions.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include "concurrent_hash_map.h"
+#include "concurrent_map.h"
+#include "log_duration.h"
+#include "mapped_search_server.h"
+#include "process_queries.h"
+#include "request_queue.h"
+#include "segmented_search_server.h"
+
+using namespace std;
+
+string GenerateWord(mt19937& generator, int max_length) {
+    const int length = uniform_int_distribution(1, max_length)(generator);
+    string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
+    vector<string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    words.erase(unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob) {
+    string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
+    vector<string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+namespace {
+
+    // The inverted index layout SearchServer used before the flat posting lists
+    using NestedMapIndex = map<string_view, map<int, double>>;
+
+    // libstdc++ red-black tree node: color, parent, left and right links, then the value
+    template <typename Value>
+    constexpr size_t TREE_NODE_SIZE = sizeof(int) + 3 * sizeof(void*) + sizeof(Value);
+
+    size_t GetNestedMapMemoryUsage(const NestedMapIndex& index) {
+        size_t memory = 0;
+        for (const auto& [word, document_freqs] : index) {
+            memory += TREE_NODE_SIZE<NestedMapIndex::value_type>;
+            memory += document_freqs.size() * TREE_NODE_SIZE<map<int, double>::value_type>;
+        }
+        return memory;
+    }
+
+    vector<Document> FindTopDocumentsNestedMap(const NestedMapIndex& index, int document_count, string_view raw_query) {
+        set<string_view> plus_words;
+        set<string_view> minus_words;
+        for (string_view word : SplitIntoWords(raw_query)) {
+            if (word.empty()) {
+                continue;
+            }
+            if (word[0] == '-') {
+                word.remove_prefix(1);
+                minus_words.insert(word);
+            }
+            else {
+                plus_words.insert(word);
+            }
+        }
+
+        map<int, double> document_to_relevance;
+        for (const string_view word : plus_words) {
+            const auto document_freqs = index.find(word);
+            if (document_freqs == index.end()) {
+                continue;
+            }
+            const double inverse_document_freq = log(document_count * 1.0 / document_freqs->second.size());
+            for (const auto [document_id, term_freq] : document_freqs->second) {
+                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+            }
+        }
+        for (const string_view word : minus_words) {
+            const auto document_freqs = index.find(word);
+            if (document_freqs == index.end()) {
+                continue;
+            }
+            for (const auto [document_id, _] : document_freqs->second) {
+                document_to_relevance.erase(document_id);
+            }
+        }
+
+        vector<Document> matched_documents;
+        for (const auto [document_id, relevance] : document_to_relevance) {
+            matched_documents.push_back({ document_id, relevance, 0 });
+        }
+        sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
+            return lhs.relevance > rhs.relevance;
+            });
+        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        }
+        return matched_documents;
+    }
+
+}
+
+void BenchmarkIndexLayouts() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+
+    NestedMapIndex nested_map_index;
+    for (const int document_id : search_server) {
+        for (const auto [word, term_freq] : search_server.GetWordFrequencies(document_id)) {
+            nested_map_index[word][document_id] = term_freq;
+        }
+    }
+
+    const auto queries = GenerateQueries(generator, dictionary, 100, 70);
+
+    cout << "nested map index: "s << GetNestedMapMemoryUsage(nested_map_index) / 1024 << " KiB"s << endl;
+    cout << "flat posting lists: "s << search_server.GetIndexMemoryUsage() / 1024 << " KiB"s << endl;
+
+    {
+        LOG_DURATION("nested map queries"s);
+        double total_relevance = 0;
+        for (const string_view query : queries) {
+            for (const auto& document : FindTopDocumentsNestedMap(nested_map_index, search_server.GetDocumentCount(), query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        cout << total_relevance << endl;
+    }
+    {
+        LOG_DURATION("flat posting list queries"s);
+        double total_relevance = 0;
+        for (const string_view query : queries) {
+            for (const auto& document : search_server.FindTopDocuments(query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        cout << total_relevance << endl;
+    }
+}
+
+void BenchmarkRemoveDocuments() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 100'000, 70);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+
+    const int document_count = search_server.GetDocumentCount();
+    {
+        LOG_DURATION("remove 5% seq"s);
+        for (int document_id = 0; document_id < document_count; document_id += 20) {
+            search_server.RemoveDocument(document_id);
+        }
+    }
+    {
+        LOG_DURATION("remove 5% par"s);
+        for (int document_id = 10; document_id < document_count; document_id += 20) {
+            search_server.RemoveDocument(execution::par, document_id);
+        }
+    }
+    cout << search_server.GetDocumentCount() << " documents left"s << endl;
+}
+
+void BenchmarkAddDocuments() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 50'000, 70);
+
+    const auto report = [&documents](string_view mark, chrono::steady_clock::duration duration) {
+        const double seconds = chrono::duration<double>(duration).count();
+        cout << mark << ": "s << static_cast<int64_t>(documents.size() / seconds) << " documents/s"s << endl;
+    };
+
+    {
+        SearchServer search_server(dictionary[0]);
+        const auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        report("AddDocument"sv, chrono::steady_clock::now() - start);
+    }
+    {
+        SearchServer search_server(dictionary[0]);
+        vector<SearchServer::NewDocument> new_documents;
+        new_documents.reserve(documents.size());
+        for (size_t i = 0; i < documents.size(); ++i) {
+            new_documents.push_back({ static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+        }
+        const auto start = chrono::steady_clock::now();
+        search_server.AddDocuments(execution::par, new_documents);
+        report("AddDocuments par"sv, chrono::steady_clock::now() - start);
+    }
+}
+
+namespace {
+
+    // Splits the keys between thread_count threads, each calling add(key) for its share
+    template <typename Add>
+    void AddConcurrently(const vector<int>& keys, int thread_count, Add add) {
+        vector<thread> threads;
+        const size_t part_length = keys.size() / thread_count;
+        for (int i = 0; i < thread_count; ++i) {
+            const auto part_begin = keys.begin() + i * part_length;
+            const auto part_end = (i == thread_count - 1) ? keys.end() : part_begin + part_length;
+            threads.emplace_back([part_begin, part_end, &add] {
+                for (auto it = part_begin; it != part_end; ++it) {
+                    add(*it);
+                }
+                });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+}
+
+void BenchmarkConcurrentMaps() {
+    static constexpr int KEY_COUNT = 100'000;
+    static constexpr int ADD_COUNT = 4'000'000;
+
+    mt19937 generator;
+    vector<int> keys(ADD_COUNT);
+    for (int& key : keys) {
+        key = uniform_int_distribution(0, KEY_COUNT - 1)(generator);
+    }
+
+    for (const int thread_count : { 1, 2, 4, 8, 16, 32, 64 }) {
+        cout << thread_count << " threads"s << endl;
+        double total = 0;
+        {
+            LOG_DURATION("  ConcurrentMap"s);
+            ConcurrentMap<int, double> relevances(10000);
+            AddConcurrently(keys, thread_count, [&relevances](int key) {
+                relevances[key].ref_to_value += 1.0;
+                });
+            for (const auto [key, relevance] : relevances.BuildOrdinaryMap()) {
+                total += relevance;
+            }
+        }
+        {
+            LOG_DURATION("  ConcurrentHashMap"s);
+            ConcurrentHashMap<int, double> relevances(KEY_COUNT);
+            AddConcurrently(keys, thread_count, [&relevances](int key) {
+                relevances.Add(key, 1.0);
+                });
+            relevances.ForEach([&total](int key, double relevance) {
+                total -= relevance;
+                });
+        }
+        if (total != 0) {
+            cout << "  totals differ by "s << total << endl;
+        }
+    }
+}
+
+void BenchmarkQuerySizes() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+
+    for (const int word_count : { 1, 3, 10, 30, 70 }) {
+        const auto queries = GenerateQueries(generator, dictionary, 500, word_count);
+        cout << word_count << " words"s << endl;
+        double total_relevance = 0;
+        {
+            LOG_DURATION("  seq"s);
+            for (const string_view query : queries) {
+                for (const auto& document : search_server.FindTopDocuments(execution::seq, query)) {
+                    total_relevance += document.relevance;
+                }
+            }
+        }
+        {
+            LOG_DURATION("  par"s);
+            for (const string_view query : queries) {
+                for (const auto& document : search_server.FindTopDocuments(execution::par, query)) {
+                    total_relevance -= document.relevance;
+                }
+            }
+        }
+        if (abs(total_relevance) > 1e-6) {
+            cout << "  results differ"s << endl;
+        }
+    }
+}
+
+void BenchmarkSegmentedIndex() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 50'000, 70);
+    const auto queries = GenerateQueries(generator, dictionary, 500, 7);
+
+    const auto report = [&documents](string_view mark, chrono::steady_clock::duration duration) {
+        const double seconds = chrono::duration<double>(duration).count();
+        cout << mark << ": "s << static_cast<int64_t>(documents.size() / seconds) << " documents/s"s << endl;
+    };
+
+    double total_relevance = 0;
+    {
+        SearchServer search_server(dictionary[0]);
+        const auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        report("SearchServer AddDocument"sv, chrono::steady_clock::now() - start);
+
+        LOG_DURATION("SearchServer queries"s);
+        for (const string_view query : queries) {
+            for (const auto& document : search_server.FindTopDocuments(query)) {
+                total_relevance += document.relevance;
+            }
+        }
+    }
+    {
+        SegmentedSearchServer search_server(dictionary[0]);
+        atomic<bool> is_ingesting = true;
+        atomic<int> concurrent_query_count = 0;
+        thread reader([&] {
+            for (size_t i = 0; is_ingesting; i = (i + 1) % queries.size()) {
+                search_server.FindTopDocuments(queries[i]);
+                ++concurrent_query_count;
+            }
+        });
+        const auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        search_server.Flush();
+        report("SegmentedSearchServer AddDocument"sv, chrono::steady_clock::now() - start);
+        is_ingesting = false;
+        reader.join();
+        cout << "  queries served during ingestion: "s << concurrent_query_count << ", segments: "s << search_server.GetSegmentCount() << endl;
+
+        LOG_DURATION("SegmentedSearchServer queries"s);
+        for (const string_view query : queries) {
+            for (const auto& document : search_server.FindTopDocuments(query)) {
+                total_relevance -= document.relevance;
+            }
+        }
+    }
+    if (abs(total_relevance) > 1e-6) {
+        cout << "Results differ"s << endl;
+    }
+}
+
+void BenchmarkIndexStartup() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 50'000, 70);
+    const auto queries = GenerateQueries(generator, dictionary, 500, 7);
+    const string path = (filesystem::temp_directory_path() / "search_server_index.bin"s).string();
+
+    {
+        const auto start = chrono::steady_clock::now();
+        SearchServer search_server(dictionary[0]);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        cout << "Re-ingestion: "s << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count() << " ms"s << endl;
+
+        ofstream output(path, ios::binary);
+        search_server.Save(output);
+        cout << "  index file: "s << output.tellp() / 1024 << " KiB"s << endl;
+    }
+    {
+        const auto start = chrono::steady_clock::now();
+        MappedSearchServer search_server(path);
+        cout << "Mapping: "s << chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count() << " us"s << endl;
+
+        LOG_DURATION("  queries on the mapped index"s);
+        for (const string_view query : queries) {
+            search_server.FindTopDocuments(query);
+        }
+    }
+    filesystem::remove(path);
+}
+
+namespace {
+
+    // SplitIntoWords before the vectorized tokenizer, followed by the per-word IsValidWord scan
+    vector<string_view> SplitIntoWordsByFind(string_view text) {
+        vector<string_view> result;
+        while (true) {
+            const size_t space = text.find(' ');
+            result.push_back(text.substr(0, space));
+            if (space == text.npos) {
+                break;
+            }
+            text.remove_prefix(space + 1);
+        }
+        for (const string_view word : result) {
+            if (!IsValidWord(word)) {
+                throw invalid_argument("Word "s + string(word) + " is invalid"s);
+            }
+        }
+        return result;
+    }
+
+}
+
+void BenchmarkTokenizer() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 50'000, 70);
+    size_t byte_count = 0;
+    for (const string& document : documents) {
+        byte_count += document.size();
+    }
+    const int repeat_count = 10;
+
+    size_t word_count = 0;
+    const auto measure = [&](string_view mark, auto tokenize) {
+        const auto start = chrono::steady_clock::now();
+        for (int i = 0; i < repeat_count; ++i) {
+            for (const string& document : documents) {
+                word_count += tokenize(document);
+            }
+        }
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << mark << ": "s << static_cast<int64_t>(byte_count * repeat_count / seconds / (1 << 20)) << " MB/s"s << endl;
+    };
+
+    measure("find and IsValidWord"sv, [](string_view text) {
+        return SplitIntoWordsByFind(text).size();
+        });
+    measure("SplitIntoWords"sv, [](string_view text) {
+        return SplitIntoWords(text).size();
+        });
+    vector<string_view> words;
+    measure("SplitIntoValidWords"sv, [&words](string_view text) {
+        if (!SplitIntoValidWords(text, words)) {
+            throw invalid_argument("Text is invalid"s);
+        }
+        return words.size();
+        });
+    if (word_count % 3 != 0) {
+        cout << "Word counts differ"s << endl;
+    }
+}
+
+void BenchmarkQueryCache() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
+    const auto distinct_queries = GenerateQueries(generator, dictionary, 1000, 7);
+
+    // Skewed repetition: a few queries make up most of the traffic
+    vector<string_view> traffic;
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (int i = 0; i < 5'000; ++i) {
+        traffic.push_back(distinct_queries[static_cast<size_t>(distinct_queries.size() * pow(uniform(generator), 3))]);
+    }
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+
+    // Every pass serves the whole traffic; the total relevance tells whether results differ
+    const auto serve = [&traffic](const string& mark, auto find_top_documents) {
+        LOG_DURATION(mark);
+        double total_relevance = 0;
+        for (const string_view query : traffic) {
+            for (const auto& document : find_top_documents(query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        return total_relevance;
+    };
+    const auto check = [](double expected, double actual) {
+        if (abs(expected - actual) > 1e-6) {
+            cout << "  results differ"s << endl;
+        }
+    };
+
+    const double total_relevance = serve("Raw queries"s, [&search_server](string_view query) {
+        return search_server.FindTopDocuments(query);
+        });
+
+    map<string_view, SearchServer::PreparedQuery> prepared_queries;
+    for (const string& query : distinct_queries) {
+        prepared_queries.emplace(query, search_server.Prepare(query));
+    }
+    check(total_relevance, serve("Prepared queries"s, [&search_server, &prepared_queries](string_view query) {
+        return search_server.FindTopDocuments(prepared_queries.at(query));
+        }));
+
+    for (const size_t capacity : { 16, 64, 256 }) {
+        search_server.SetResultCacheCapacity(capacity);
+        check(total_relevance, serve("Cache of "s + to_string(capacity), [&search_server](string_view query) {
+            return search_server.FindTopDocuments(query);
+            }));
+        const auto stats = search_server.GetResultCacheStats();
+        cout << "  hits: "s << stats.hit_count << ", misses: "s << stats.miss_count << endl;
+    }
+
+    // The cached queries of ProcessQueries run in parallel on the shards of the cache
+    const vector<string> traffic_queries(traffic.begin(), traffic.end());
+    for (const size_t capacity : { 0, 256 }) {
+        search_server.SetResultCacheCapacity(capacity);
+        LOG_DURATION("ProcessQueries, cache of "s + to_string(capacity));
+        double process_total_relevance = 0;
+        for (const auto& documents : ProcessQueries(search_server, traffic_queries)) {
+            for (const Document& document : documents) {
+                process_total_relevance += document.relevance;
+            }
+        }
+        check(total_relevance, process_total_relevance);
+    }
+    search_server.SetResultCacheCapacity(0);
+}
+
+void BenchmarkQueryFilters() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 50'000, 70);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const auto status = static_cast<DocumentStatus>(generator() % 4);
+        search_server.AddDocument(i, documents[i], status, { 1, 2, 3 });
+    }
+
+    vector<string> queries;
+    for (int i = 0; i < 1000; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, 10, 0.3));
+    }
+
+    for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+        cout << (status == DocumentStatus::ACTUAL ? "ACTUAL"s : "BANNED"s) << endl;
+        vector<vector<Document>> by_predicate;
+        vector<vector<Document>> by_status;
+        {
+            LOG_DURATION("  predicate"s);
+            for (const string_view query : queries) {
+                by_predicate.push_back(search_server.FindTopDocuments(execution::seq, query, [status](int document_id, DocumentStatus document_status, int rating) {
+                    return document_status == status;
+                    }));
+            }
+        }
+        {
+            LOG_DURATION("  status bitset"s);
+            for (const string_view query : queries) {
+                by_status.push_back(search_server.FindTopDocuments(execution::seq, query, status));
+            }
+        }
+        const bool is_same = equal(by_predicate.begin(), by_predicate.end(), by_status.begin(), by_status.end(),
+            [](const vector<Document>& lhs, const vector<Document>& rhs) {
+                return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& lhs, const Document& rhs) {
+                    return lhs.id == rhs.id && lhs.relevance == rhs.relevance;
+                    });
+            });
+        if (!is_same) {
+            cout << "  results differ"s << endl;
+        }
+    }
+}
+
+namespace {
+
+    // Documents of min_word_count to max_word_count words drawn with probabilities inversely proportional to their rank,
+    // as in natural text
+    vector<string> GenerateZipfDocuments(mt19937& generator, const vector<string>& dictionary, int document_count,
+        int min_word_count = 10, int max_word_count = 100) {
+        vector<double> weights;
+        for (size_t rank = 1; rank <= dictionary.size(); ++rank) {
+            weights.push_back(1.0 / rank);
+        }
+        discrete_distribution<size_t> word_distribution(weights.begin(), weights.end());
+        vector<string> documents;
+        for (int i = 0; i < document_count; ++i) {
+            const int word_count = uniform_int_distribution(min_word_count, max_word_count)(generator);
+            string document;
+            for (int j = 0; j < word_count; ++j) {
+                if (j > 0) {
+                    document.push_back(' ');
+                }
+                document += dictionary[word_distribution(generator)];
+            }
+            documents.push_back(move(document));
+        }
+        return documents;
+    }
+
+    // Runs the queries in both modes of the server and prints the latency percentiles of each
+    void MeasureQueryModes(SearchServer& search_server, const vector<string>& queries, DocumentStatus status) {
+        vector<double> latencies[2];
+        for (const string_view query : queries) {
+            for (const auto mode : { SearchServer::QueryMode::EXHAUSTIVE, SearchServer::QueryMode::PRUNED }) {
+                search_server.SetQueryMode(mode);
+                const int index = mode == SearchServer::QueryMode::PRUNED;
+                const auto start = chrono::steady_clock::now();
+                search_server.FindTopDocuments(execution::seq, query, status);
+                latencies[index].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+            }
+        }
+        search_server.SetQueryMode(SearchServer::QueryMode::EXHAUSTIVE);
+        for (const int index : { 0, 1 }) {
+            auto& query_latencies = latencies[index];
+            sort(query_latencies.begin(), query_latencies.end());
+            cout << (index == 0 ? "    exhaustive"s : "    pruned"s)
+                << ": p50 "s << static_cast<int>(query_latencies[query_latencies.size() / 2])
+                << " us, p99 "s << static_cast<int>(query_latencies[query_latencies.size() * 99 / 100]) << " us"s << endl;
+        }
+    }
+
+}
+
+void BenchmarkQueryPruning() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2000, 10);
+    for (const bool is_zipf : { false, true }) {
+        cout << (is_zipf ? "Zipf corpus"s : "Uniform corpus"s) << endl;
+        const auto documents = is_zipf ? GenerateZipfDocuments(generator, dictionary, 50'000) : GenerateQueries(generator, dictionary, 50'000, 70);
+        SearchServer search_server(dictionary[0]);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            const auto status = static_cast<DocumentStatus>(generator() % 4);
+            search_server.AddDocument(i, documents[i], status, { static_cast<int>(generator() % 10) });
+        }
+        // Tombstones in the posting lists
+        for (size_t i = 0; i < documents.size(); i += 7) {
+            search_server.RemoveDocument(i);
+        }
+
+        for (const int word_count : { 1, 3, 10, 30, 70 }) {
+            vector<string> queries;
+            for (int i = 0; i < 300; ++i) {
+                queries.push_back(GenerateQuery(generator, dictionary, word_count, 0.1));
+            }
+            cout << "  "s << word_count << " words"s << endl;
+            MeasureQueryModes(search_server, queries, DocumentStatus::ACTUAL);
+            if (word_count == 10) {
+                cout << "  10 words, BANNED"s << endl;
+                MeasureQueryModes(search_server, queries, DocumentStatus::BANNED);
+                search_server.FreezeIndex();
+                cout << "  10 words, frozen index"s << endl;
+                MeasureQueryModes(search_server, queries, DocumentStatus::ACTUAL);
+                search_server.AddDocument(documents.size(), documents[0], DocumentStatus::ACTUAL, { 1 });
+            }
+        }
+    }
+}
+
+void BenchmarkCompression() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2000, 10);
+    const auto documents = GenerateZipfDocuments(generator, dictionary, 100'000);
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    size_t posting_count = 0;
+    for (const int document_id : search_server) {
+        posting_count += search_server.GetWordFrequencies(document_id).size();
+    }
+    vector<string> queries;
+    for (int i = 0; i < 500; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, uniform_int_distribution(1, 10)(generator)));
+    }
+
+    // Returns the results of the queries and prints the memory and throughput of the current layout
+    const auto run = [&](string_view mark) {
+        vector<vector<Document>> results;
+        results.reserve(queries.size());
+        const auto start = chrono::steady_clock::now();
+        for (const string_view query : queries) {
+            results.push_back(search_server.FindTopDocuments(execution::seq, query));
+        }
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << mark << ": "s << static_cast<double>(search_server.GetIndexMemoryUsage()) / posting_count << " bytes/posting, "s
+            << static_cast<int64_t>(queries.size() / seconds) << " queries/s"s << endl;
+        return results;
+    };
+    // Queries whose documents differ, and those whose relevances differ
+    const auto count_changed = [](const vector<vector<Document>>& expected, const vector<vector<Document>>& actual) {
+        pair<size_t, size_t> changed_counts{ 0, 0 };
+        for (size_t i = 0; i < expected.size(); ++i) {
+            changed_counts.first += !equal(expected[i].begin(), expected[i].end(), actual[i].begin(), actual[i].end(),
+                [](const Document& lhs, const Document& rhs) {
+                    return lhs.id == rhs.id;
+                });
+            changed_counts.second += !equal(expected[i].begin(), expected[i].end(), actual[i].begin(), actual[i].end(),
+                [](const Document& lhs, const Document& rhs) {
+                    return lhs.id == rhs.id && lhs.relevance == rhs.relevance;
+                });
+        }
+        return changed_counts;
+    };
+
+    const auto expected = run("uncompressed"sv);
+    for (const auto& [precision, mark] : { pair{ TermFreqPrecision::FULL, "full term frequencies"sv },
+                                           pair{ TermFreqPrecision::BITS_16, "16-bit term frequencies"sv },
+                                           pair{ TermFreqPrecision::BITS_8, "8-bit term frequencies"sv } }) {
+        search_server.CompressIndex(precision);
+        const auto [document_changed_count, relevance_changed_count] = count_changed(expected, run(mark));
+        cout << "  of "s << queries.size() << " queries, "s << document_changed_count << " return other documents, "s
+            << relevance_changed_count << " other relevances"s << endl;
+    }
+}
+
+void BenchmarkProcessQueries() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 70);
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    string query_text;
+    for (int i = 0; i < 200'000; ++i) {
+        query_text += GenerateQuery(generator, dictionary, uniform_int_distribution(1, 10)(generator));
+        query_text.push_back('\n');
+    }
+    // The batch API needs all queries in memory, the streaming one reads them from the stream
+    vector<string> queries;
+    {
+        istringstream input(query_text);
+        for (string query; getline(input, query);) {
+            queries.push_back(move(query));
+        }
+    }
+
+    const auto report = [&queries](string_view mark, chrono::steady_clock::duration duration, size_t result_bytes) {
+        const double seconds = chrono::duration<double>(duration).count();
+        cout << mark << ": "s << static_cast<int64_t>(queries.size() / seconds) << " queries/s, "s
+            << result_bytes / 1024 << " KiB of results held"s << endl;
+    };
+
+    {
+        const auto start = chrono::steady_clock::now();
+        const auto results = ProcessQueries(search_server, queries);
+        const auto duration = chrono::steady_clock::now() - start;
+        size_t result_bytes = results.capacity() * sizeof(vector<Document>);
+        for (const auto& query_documents : results) {
+            result_bytes += query_documents.capacity() * sizeof(Document);
+        }
+        report("ProcessQueries"sv, duration, result_bytes);
+    }
+    {
+        const auto start = chrono::steady_clock::now();
+        const auto joined = ProcessQueriesJoined(search_server, queries);
+        report("ProcessQueriesJoined"sv, chrono::steady_clock::now() - start, joined.capacity() * sizeof(Document));
+    }
+    for (const size_t window_size : { 16, 256, 4096 }) {
+        istringstream input(query_text);
+        vector<Document> joined;
+        const auto start = chrono::steady_clock::now();
+        ProcessQueriesStreamed(search_server, input, [&joined](vector<Document>&& documents) {
+            joined.insert(joined.end(), documents.begin(), documents.end());
+            }, window_size);
+        // Up to window_size result vectors wait in the window
+        report("streamed, window "s + to_string(window_size), chrono::steady_clock::now() - start,
+            window_size * MAX_RESULT_DOCUMENT_COUNT * sizeof(Document));
+    }
+}
+
+void BenchmarkQueryBatches() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2000, 10);
+    const auto documents = GenerateZipfDocuments(generator, dictionary, 50'000);
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const auto status = static_cast<DocumentStatus>(generator() % 4);
+        search_server.AddDocument(i, documents[i], status, { static_cast<int>(generator() % 10) });
+    }
+    // Popular words recur across queries, as in real traffic
+    auto queries = GenerateZipfDocuments(generator, dictionary, 20'000, 1, 10);
+    for (string& query : queries) {
+        if (generator() % 10 == 0) {
+            query += " -"s + dictionary[generator() % dictionary.size()];
+        }
+    }
+
+    const auto report = [&queries](string_view mark, chrono::steady_clock::duration duration) {
+        const double seconds = chrono::duration<double>(duration).count();
+        cout << "  "s << mark << ": "s << static_cast<int64_t>(queries.size() / seconds) << " queries/s"s << endl;
+    };
+    for (const bool is_frozen : { false, true }) {
+        if (is_frozen) {
+            search_server.FreezeIndex();
+        }
+        cout << (is_frozen ? "Frozen index"s : "Regular index"s) << endl;
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+            vector<vector<Document>> results;
+            auto start = chrono::steady_clock::now();
+            for (const string_view query : queries) {
+                results.push_back(search_server.FindTopDocuments(execution::seq, query, status));
+            }
+            report(status == DocumentStatus::ACTUAL ? "per query, ACTUAL"sv : "per query, BANNED"sv, chrono::steady_clock::now() - start);
+
+            vector<vector<Document>> batched;
+            start = chrono::steady_clock::now();
+            for (size_t first = 0; first < queries.size(); first += QUERY_BATCH_SIZE) {
+                const vector<string_view> batch(queries.begin() + first, queries.begin() + min(queries.size(), first + QUERY_BATCH_SIZE));
+                for (auto& documents : search_server.FindTopDocumentsBatch(batch, status)) {
+                    batched.push_back(move(documents));
+                }
+            }
+            report(status == DocumentStatus::ACTUAL ? "batched, ACTUAL"sv : "batched, BANNED"sv, chrono::steady_clock::now() - start);
+        }
+    }
+
+    cout << "Parallel"s << endl;
+    auto start = chrono::steady_clock::now();
+    ProcessQueries(search_server, queries);
+    report("ProcessQueries"sv, chrono::steady_clock::now() - start);
+    start = chrono::steady_clock::now();
+    ProcessQueriesBatched(search_server, queries);
+    report("ProcessQueriesBatched"sv, chrono::steady_clock::now() - start);
+}
+
+void BenchmarkMatchDocuments() {
+    mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2000, 10);
+    const auto documents = GenerateZipfDocuments(generator, dictionary, 50'000);
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    vector<string> queries;
+    for (int i = 0; i < 2'000; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, uniform_int_distribution(1, 20)(generator), 0.1));
+    }
+
+    using Match = tuple<vector<string_view>, DocumentStatus>;
+    for (const size_t page_size : { MAX_RESULT_DOCUMENT_COUNT, 100 }) {
+        vector<vector<int>> pages;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            vector<int> page;
+            for (size_t j = 0; j < page_size; ++j) {
+                page.push_back(generator() % documents.size());
+            }
+            pages.push_back(move(page));
+        }
+        cout << "Pages of "s << page_size << " documents"s << endl;
+
+        // Runs match_page(query, page) for every query and prints the throughput in matched documents per second
+        const auto run = [&](string_view mark, auto match_page) {
+            vector<vector<Match>> matches;
+            const auto start = chrono::steady_clock::now();
+            for (size_t i = 0; i < queries.size(); ++i) {
+                matches.push_back(match_page(queries[i], pages[i]));
+            }
+            const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            cout << "  "s << mark << ": "s << static_cast<int64_t>(queries.size() * page_size / seconds) << " documents/s"s << endl;
+        };
+        run("MatchDocument seq"sv, [&search_server](string_view query, const vector<int>& page) {
+            vector<Match> matches;
+            for (const int document_id : page) {
+                matches.push_back(search_server.MatchDocument(execution::seq, query, document_id));
+            }
+            return matches;
+            });
+        run("MatchDocument par"sv, [&search_server](string_view query, const vector<int>& page) {
+            vector<Match> matches;
+            for (const int document_id : page) {
+                matches.push_back(search_server.MatchDocument(execution::par, query, document_id));
+            }
+            return matches;
+            });
+        run("MatchDocuments seq"sv, [&search_server](string_view query, const vector<int>& page) {
+            return search_server.MatchDocuments(execution::seq, query, page);
+            });
+        run("MatchDocuments par"sv, [&search_server](string_view query, const vector<int>& page) {
+            return search_server.MatchDocuments(execution::par, query, page);
+            });
+    }
+}
+
+namespace {
+
+    // The request log as it was before the ring buffer: a deque of the requests in the window under a lock,
+    // here with a running no-result counter so that only the recording cost differs
+    class LockedRequestLog {
+    public:
+        explicit LockedRequestLog(size_t capacity)
+            : capacity_(capacity) {
+        }
+
+        void Record(size_t result_count) {
+            lock_guard guard(mutex_);
+            requests_.push_back(result_count);
+            no_result_count_ += result_count == 0;
+            if (requests_.size() > capacity_) {
+                no_result_count_ -= requests_.front() == 0;
+                requests_.pop_front();
+            }
+        }
+
+    private:
+        const size_t capacity_;
+        mutable mutex mutex_;
+        deque<size_t> requests_;
+        size_t no_result_count_ = 0;
+    };
+
+}
+
+void BenchmarkRequestQueue() {
+    static constexpr int RECORD_COUNT = 4'000'000;
+    static constexpr size_t CAPACITY = 1440;
+
+    mt19937 generator;
+    // Result counts, a quarter of them empty
+    vector<int> result_counts(RECORD_COUNT);
+    for (int& result_count : result_counts) {
+        result_count = generator() % 4 == 0 ? 0 : uniform_int_distribution(1, MAX_RESULT_DOCUMENT_COUNT)(generator);
+    }
+
+    const SearchServer search_server(""s);
+    for (const int thread_count : { 1, 2, 4, 8, 16, 32 }) {
+        cout << thread_count << " threads"s << endl;
+        RequestQueue request_queue(search_server, CAPACITY);
+        LockedRequestLog locked_log(CAPACITY);
+        {
+            LOG_DURATION("  RequestQueue"s);
+            AddConcurrently(result_counts, thread_count, [&request_queue](int result_count) {
+                request_queue.Record(result_count, chrono::microseconds(100));
+                });
+        }
+        {
+            LOG_DURATION("  locked deque"s);
+            AddConcurrently(result_counts, thread_count, [&locked_log](int result_count) {
+                locked_log.Record(result_count);
+                });
+        }
+    }
+}
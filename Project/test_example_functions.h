@@ -1 +1,70 @@
-#pragma once
\ No newline at end of file
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+std::string GenerateWord(std::mt19937& generator, int max_length);
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length);
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count, double minus_prob = 0);
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary, int query_count, int max_word_count);
+
+// Memory and query latency of the flat posting lists side by side with the former nested std::map layout
+void BenchmarkIndexLayouts();
+
+// Removes 10% of a 100k-document corpus, half sequentially and half with the parallel policy
+void BenchmarkRemoveDocuments();
+
+// Indexing throughput in documents per second of AddDocument against the parallel AddDocuments
+void BenchmarkAddDocuments();
+
+// Concurrent relevance accumulation into ConcurrentMap and ConcurrentHashMap at 1 to 64 threads
+void BenchmarkConcurrentMaps();
+
+// Sequential and parallel FindTopDocuments on queries of 1 to 70 words
+void BenchmarkQuerySizes();
+
+// Ingestion throughput and query latency of SegmentedSearchServer, with queries running alongside
+// the ingestion and after the final merge, against SearchServer on the same corpus
+void BenchmarkSegmentedIndex();
+
+// Startup time of re-ingesting a corpus against opening its saved index with MappedSearchServer
+void BenchmarkIndexStartup();
+
+// Tokenizing throughput in MB/s of the former split and validation against SplitIntoValidWords
+void BenchmarkTokenizer();
+
+// Repeated traffic served by raw queries, by prepared queries and through result caches of several sizes,
+// then by ProcessQueries with and without a cache
+void BenchmarkQueryCache();
+
+// Queries with minus words filtered by status through a predicate and through the status bitsets
+void BenchmarkQueryFilters();
+
+// Per-query latency percentiles of the exhaustive and the pruned query mode on queries of 1 to 70 words.
+// tests/query_pruning_tests.cpp checks that the modes agree
+void BenchmarkQueryPruning();
+
+// Bytes per posting and query throughput of the uncompressed index against compressed ones with full,
+// 16-bit and 8-bit term frequencies, with the number of queries whose results quantization changes
+void BenchmarkCompression();
+
+// Throughput of ProcessQueries and ProcessQueriesJoined on 200k queries against ProcessQueriesStreamed
+// reading them from a stream with windows of several sizes
+void BenchmarkProcessQueries();
+
+// Throughput of queries run one by one against FindTopDocumentsBatch and of ProcessQueries against
+// ProcessQueriesBatched, on a Zipf corpus and queries
+void BenchmarkQueryBatches();
+
+// Documents matched per second by MatchDocument with both policies against MatchDocuments on
+// result pages of 5 and 100 documents
+void BenchmarkMatchDocuments();
+
+// Recording throughput of RequestQueue against a deque under a lock at 1 to 32 threads
+void BenchmarkRequestQueue();
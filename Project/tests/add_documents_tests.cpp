@@ -0,0 +1,143 @@
+#include <execution>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    const vector<string> QUERIES = {
+        "w0"s,
+        "w1 w2 w3 and"s,
+        "w0 w1 w2 w3 w4 w5 -w6"s,
+        "w10 w30 w39 -w0"s,
+        "fresh w1"s,
+    };
+
+    struct Texts {
+        vector<string> texts;
+        vector<SearchServer::NewDocument> documents;
+    };
+
+    // The texts own the characters the documents view. A stop-word-only document is among them
+    Texts MakeDocuments(unsigned seed, int first_id, int document_count) {
+        Texts result;
+        mt19937 generator(seed);
+        for (int i = 0; i < document_count; ++i) {
+            string text = i == 3 ? "and with"s : ""s;
+            const int word_count = i == 3 ? 0 : 1 + generator() % 15;
+            for (int j = 0; j < word_count; ++j) {
+                text += (j == 0 ? "w"s : " w"s) + to_string(generator() % 40 * (generator() % 40) / 40);
+            }
+            result.texts.push_back(move(text));
+        }
+        for (int i = 0; i < document_count; ++i) {
+            const vector<int> ratings = { static_cast<int>(generator() % 10) - 3, static_cast<int>(generator() % 10) };
+            result.documents.push_back({ first_id + i, result.texts[i], static_cast<DocumentStatus>(generator() % 3), ratings });
+        }
+        return result;
+    }
+
+    bool IsRejected(const function<void()>& add_documents, string* error = nullptr) {
+        try {
+            add_documents();
+        }
+        catch (const invalid_argument& e) {
+            if (error != nullptr) {
+                *error = e.what();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // The same rejection with every way to call AddDocuments, and nothing changed by any of them
+    void AssertRejectedAtomically(SearchServer& search_server, const SearchServer& expected,
+        const vector<SearchServer::NewDocument>& documents, const string& hint) {
+        const uint64_t generation = search_server.GetGeneration();
+        const bool is_frozen = search_server.IsIndexFrozen();
+        ASSERT_HINT(IsRejected([&] { search_server.AddDocuments(documents); }), hint);
+        ASSERT_HINT(IsRejected([&] { search_server.AddDocuments(execution::seq, documents); }), hint + ", seq"s);
+        ASSERT_HINT(IsRejected([&] { search_server.AddDocuments(execution::par, documents); }), hint + ", par"s);
+        ASSERT_EQUAL_HINT(search_server.GetGeneration(), generation, hint);
+        ASSERT_EQUAL_HINT(search_server.IsIndexFrozen(), is_frozen, hint);
+        AssertSameIndex(search_server, expected, QUERIES, hint);
+    }
+
+}
+
+TEST_CASE(TestAddDocumentsMatchesAddDocument) {
+    const Texts texts = MakeDocuments(6, 0, 3000);
+    SearchServer expected("and with"s);
+    for (const SearchServer::NewDocument& document : texts.documents) {
+        expected.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+
+    // Batches of growing sizes from the empty one, each added on top of the previous ones
+    SearchServer sequential("and with"s);
+    SearchServer parallel("and with"s);
+    size_t begin = 0;
+    for (size_t batch_size = 0; begin < texts.documents.size(); batch_size = batch_size * 2 + 1) {
+        const size_t end = min(texts.documents.size(), begin + batch_size);
+        const vector<SearchServer::NewDocument> batch(texts.documents.begin() + begin, texts.documents.begin() + end);
+        sequential.AddDocuments(execution::seq, batch);
+        parallel.AddDocuments(execution::par, batch);
+        begin = end;
+    }
+    AssertSameIndex(sequential, expected, QUERIES, "seq"s);
+    AssertSameIndex(parallel, expected, QUERIES, "par"s);
+    ASSERT(parallel.GetWordFrequencies(3).empty());
+    ASSERT_EQUAL(parallel.GetGeneration(), expected.GetGeneration());
+}
+
+TEST_CASE(TestAddDocumentsRejectsInvalidIds) {
+    SearchServer search_server = MakeRandomSearchServer(6, 100, 40, 0);
+    const SearchServer expected = MakeRandomSearchServer(6, 100, 40, 0);
+    const Texts texts = MakeDocuments(7, 100, 10);
+    const auto with_id = [&texts](size_t i, int document_id) {
+        vector<SearchServer::NewDocument> documents = texts.documents;
+        documents[i].id = document_id;
+        return documents;
+    };
+
+    AssertRejectedAtomically(search_server, expected, with_id(5, -1), "negative id"s);
+    AssertRejectedAtomically(search_server, expected, with_id(9, 104), "id repeated in the batch"s);
+    AssertRejectedAtomically(search_server, expected, with_id(0, 99), "id already in the index"s);
+    // A document added and removed earlier leaves its id free
+    search_server.RemoveDocument(50);
+    search_server.AddDocuments(execution::par, with_id(0, 50));
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 109);
+}
+
+TEST_CASE(TestAddDocumentsRejectsControlCharacters) {
+    SearchServer search_server = MakeRandomSearchServer(8, 100, 40, 0);
+    SearchServer expected = MakeRandomSearchServer(8, 100, 40, 0);
+    // Rejected batches leave the index frozen
+    search_server.FreezeIndex();
+    expected.FreezeIndex();
+
+    Texts texts = MakeDocuments(9, 100, 20);
+    texts.texts[7] = "w1 fre\x12sh w2"s;
+    texts.texts[15] = "w3 \x1f"s;
+    texts.documents[7].text = texts.texts[7];
+    texts.documents[15].text = texts.texts[15];
+    AssertRejectedAtomically(search_server, expected, texts.documents, "control characters"s);
+
+    // Every document is tokenized before the check, and the first invalid one is reported
+    string error;
+    ASSERT(IsRejected([&] { search_server.AddDocuments(execution::par, texts.documents); }, &error));
+    ASSERT_EQUAL(error, "Word fre\x12sh is invalid"s);
+
+    texts.documents.erase(texts.documents.begin() + 15);
+    texts.documents.erase(texts.documents.begin() + 7);
+    search_server.AddDocuments(execution::par, texts.documents);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 118);
+    ASSERT(!search_server.IsIndexFrozen());
+}
@@ -0,0 +1,57 @@
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "counting_allocator.h"
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+
+using namespace std;
+
+TEST_CASE(TestQueryContextQueriesDoNotAllocate) {
+    const SearchServer search_server = MakeExampleSearchServer();
+    const vector<string> queries = {
+        "fluffy groomed cat"s,
+        "cat -collar"s,
+        "groomed -eyes -dog starling"s,
+        "tail tail fluffy and"s,
+        "parrot"s,
+    };
+
+    // The first pass grows the buffers of the context to the largest query
+    SearchServer::QueryContext context;
+    for (const string& query : queries) {
+        search_server.FindTopDocuments(context, query);
+        search_server.FindTopDocuments(context, query, DocumentStatus::BANNED);
+    }
+    for (const string& query : queries) {
+        ASSERT_EQUAL_HINT(CountAllocations([&] { search_server.FindTopDocuments(context, query); }), 0u, string(query));
+        ASSERT_EQUAL_HINT(CountAllocations([&] { search_server.FindTopDocuments(context, query, DocumentStatus::BANNED); }), 0u, string(query));
+    }
+}
+
+TEST_CASE(TestQueryContextResultsMatchFindTopDocuments) {
+    const SearchServer search_server = MakeExampleSearchServer();
+    SearchServer::QueryContext context;
+    for (const string_view query : { "fluffy groomed cat"sv, "cat -collar"sv, "groomed -eyes -dog starling"sv }) {
+        const vector<Document> expected = search_server.FindTopDocuments(query);
+        const vector<Document>& actual = search_server.FindTopDocuments(context, query);
+        AssertSameDocuments(actual, expected, string(query));
+    }
+}
+
+TEST_CASE(TestCacheHitsAllocateOnlyTheResult) {
+    SearchServer search_server = MakeExampleSearchServer();
+    search_server.SetResultCacheCapacity(16);
+    const vector<string> queries = { "fluffy groomed cat"s, "cat -collar"s, "expressive -cat dog"s };
+
+    // The first pass fills the cache and grows the buffers of the thread
+    for (const string& query : queries) {
+        search_server.FindTopDocuments(query);
+    }
+    for (const string& query : queries) {
+        ASSERT_EQUAL_HINT(CountAllocations([&] { search_server.FindTopDocuments(query); }), 1u, query);
+    }
+    ASSERT_EQUAL(search_server.GetResultCacheStats().hit_count, queries.size());
+}
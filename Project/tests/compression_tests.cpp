@@ -0,0 +1,96 @@
+#include <cmath>
+#include <execution>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    const int DOCUMENT_COUNT = 3000;
+
+    // Skewed word frequencies give both long lists of full blocks and short varint-coded ones
+    SearchServer MakeSearchServer() {
+        return MakeRandomSearchServer(11, DOCUMENT_COUNT, 80, 13);
+    }
+
+    const vector<string> QUERIES = {
+        "w0"s,
+        "w1 w2 w3"s,
+        "w0 w1 w2 w3 w4 w5"s,
+        "w10 w40 w70 -w0"s,
+        "w2 w9 w17 w33 -w1 -w5"s,
+        "w79"s,
+    };
+
+    // Largest number of plus words in QUERIES
+    const int MAX_QUERY_WORD_COUNT = 6;
+
+    // Exact results for max_error 0, else ranks of the two results with relevances at most max_error apart,
+    // since documents that tie up to TopDocuments' epsilon may swap places
+    void AssertSameResults(const vector<Document>& actual, const vector<Document>& expected, double max_error, const string& hint) {
+        if (max_error == 0.0) {
+            AssertSameDocuments(actual, expected, hint);
+            return;
+        }
+        ASSERT_EQUAL_HINT(actual.size(), expected.size(), hint);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_HINT(abs(actual[i].relevance - expected[i].relevance) <= max_error, hint);
+        }
+    }
+
+    template <typename ExecutionPolicy>
+    void AssertSameResults(const SearchServer& actual, const SearchServer& expected, ExecutionPolicy policy, double max_error) {
+        for (const string& query : QUERIES) {
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                AssertSameResults(actual.FindTopDocuments(policy, query, status, 50), expected.FindTopDocuments(policy, query, status, 50),
+                    max_error, query);
+            }
+        }
+    }
+
+}
+
+TEST_CASE(TestFullPrecisionCompressionKeepsResults) {
+    const SearchServer expected = MakeSearchServer();
+    SearchServer search_server = MakeSearchServer();
+    search_server.CompressIndex(TermFreqPrecision::FULL);
+    ASSERT(search_server.IsIndexCompressed());
+    ASSERT(search_server.GetIndexMemoryUsage() < expected.GetIndexMemoryUsage());
+    AssertSameResults(search_server, expected, execution::seq, 0.0);
+    AssertSameResults(search_server, expected, execution::par, 0.0);
+
+    // Pruned queries fall back to the exhaustive scan
+    search_server.SetQueryMode(SearchServer::QueryMode::PRUNED);
+    AssertSameResults(search_server, expected, execution::seq, 0.0);
+}
+
+TEST_CASE(TestQuantizedRelevancesStayClose) {
+    const SearchServer expected = MakeSearchServer();
+    // A term frequency is off by at most the largest one of its block, at most 1, over the levels
+    // of the precision, and is multiplied by an inverse document frequency of at most log(N)
+    const double max_inverse_document_freq = log(static_cast<double>(expected.GetDocumentCount()));
+    for (const auto& [precision, level_count] : { pair{ TermFreqPrecision::BITS_16, 65535.0 }, pair{ TermFreqPrecision::BITS_8, 255.0 } }) {
+        SearchServer search_server = MakeSearchServer();
+        search_server.CompressIndex(precision);
+        const double max_error = MAX_QUERY_WORD_COUNT * max_inverse_document_freq / level_count + 1e-6;
+        AssertSameResults(search_server, expected, execution::seq, max_error);
+    }
+}
+
+TEST_CASE(TestIndexChangesDecompress) {
+    SearchServer expected = MakeSearchServer();
+    SearchServer search_server = MakeSearchServer();
+    search_server.CompressIndex(TermFreqPrecision::BITS_8);
+    for (SearchServer* server : { &search_server, &expected }) {
+        server->AddDocument(DOCUMENT_COUNT, "w0 w1 w79 w79"s, DocumentStatus::ACTUAL, { 5 });
+        server->RemoveDocument(1);
+    }
+    ASSERT(!search_server.IsIndexCompressed());
+    // The lists are rebuilt from the forward index, which keeps the exact term frequencies
+    AssertSameResults(search_server, expected, execution::seq, 0.0);
+}
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_hash_map.h"
+#include "concurrent_map.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    template <typename Key, typename Value>
+    map<Key, Value> ToMap(const ConcurrentHashMap<Key, Value>& hash_map) {
+        map<Key, Value> result;
+        hash_map.ForEach([&result](Key key, Value value) {
+            const bool is_new = result.emplace(key, value).second;
+            ASSERT_HINT(is_new, "key "s + to_string(key) + " visited twice"s);
+            });
+        return result;
+    }
+
+    // Runs function(t) on thread_count threads and waits for them
+    template <typename Function>
+    void RunOnThreads(int thread_count, Function function) {
+        vector<thread> threads;
+        for (int t = 0; t < thread_count; ++t) {
+            threads.emplace_back(function, t);
+        }
+        for (thread& t : threads) {
+            t.join();
+        }
+    }
+
+}
+
+TEST_CASE(TestConcurrentHashMapMatchesMap) {
+    // Few slots, so that probe sequences are long and wrap around the table
+    ConcurrentHashMap<int, int> hash_map(64);
+    map<int, int> expected;
+    mt19937 generator(8);
+    for (int i = 0; i < 20'000; ++i) {
+        // Negative keys, and keys that share the low bits
+        const int key = static_cast<int>(generator() % 64) * 1024 - 32 * 1024;
+        if (generator() % 4 == 0) {
+            ASSERT_EQUAL(hash_map.Erase(key), expected.erase(key) == 1);
+        }
+        else {
+            const int delta = static_cast<int>(generator() % 100) - 50;
+            hash_map.Add(key, delta);
+            expected[key] += delta;
+        }
+        ASSERT_EQUAL(hash_map.Contains(key), expected.count(key) == 1);
+        ASSERT_EQUAL(hash_map.Get(key), expected.count(key) ? expected.at(key) : 0);
+    }
+    ASSERT(ToMap(hash_map) == expected);
+}
+
+TEST_CASE(TestConcurrentHashMapErasedKeyStartsFromZero) {
+    ConcurrentHashMap<int, double> hash_map(4);
+    hash_map.Add(7, 1.5);
+    hash_map.Add(7, 2.0);
+    ASSERT_EQUAL(hash_map.Get(7), 3.5);
+    ASSERT(hash_map.Erase(7));
+    ASSERT(!hash_map.Erase(7));
+    ASSERT(!hash_map.Contains(7));
+    ASSERT_EQUAL(hash_map.Get(7), 0.0);
+    // The erased slot is revived with the new delta, not added to the old value
+    hash_map.Add(7, 0.25);
+    ASSERT_EQUAL(hash_map.Get(7), 0.25);
+    ASSERT(!hash_map.Erase(8));
+}
+
+TEST_CASE(TestConcurrentHashMapThrowsWhenFull) {
+    // Two keys get a table of four slots
+    ConcurrentHashMap<int, int> hash_map(2);
+    for (int key = 0; key < 4; ++key) {
+        hash_map.Add(key, 1);
+    }
+    // Erased keys keep their slots
+    ASSERT(hash_map.Erase(0));
+    bool is_thrown = false;
+    try {
+        hash_map.Add(4, 1);
+    }
+    catch (const length_error&) {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    ASSERT_EQUAL(ToMap(hash_map).size(), 3u);
+    ASSERT(!hash_map.Contains(4));
+}
+
+// Every thread adds to every key, so that threads race both to claim the slots and to add to them
+TEST_CASE(TestConcurrentHashMapConcurrentAdds) {
+    static constexpr int KEY_COUNT = 5000;
+    static constexpr int THREAD_COUNT = 4;
+    ConcurrentHashMap<int, double> relevances(KEY_COUNT);
+    ConcurrentMap<int, double> expected(100);
+    RunOnThreads(THREAD_COUNT, [&](int t) {
+        vector<int> keys(KEY_COUNT);
+        for (int key = 0; key < KEY_COUNT; ++key) {
+            keys[key] = key;
+        }
+        shuffle(keys.begin(), keys.end(), mt19937(t));
+        for (const int key : keys) {
+            // Sums of halves are exact, whatever the order of the additions
+            relevances.Add(key, 0.5 * (t + 1));
+            expected[key].ref_to_value += 0.5 * (t + 1);
+        }
+        });
+    ASSERT(ToMap(relevances) == expected.BuildOrdinaryMap());
+    ASSERT_EQUAL(relevances.Get(KEY_COUNT - 1), 0.5 * THREAD_COUNT * (THREAD_COUNT + 1) / 2);
+}
+
+// Each thread erases and revives keys of its own while the others add to theirs; the erases
+// and revivals take the stripe locks, which keys of different threads share
+TEST_CASE(TestConcurrentHashMapConcurrentErases) {
+    static constexpr int KEYS_PER_THREAD = 500;
+    static constexpr int THREAD_COUNT = 4;
+    ConcurrentHashMap<int, int> hash_map(KEYS_PER_THREAD * THREAD_COUNT);
+    RunOnThreads(THREAD_COUNT, [&hash_map](int t) {
+        for (int round = 0; round < 20; ++round) {
+            for (int i = 0; i < KEYS_PER_THREAD; ++i) {
+                const int key = i * THREAD_COUNT + t;
+                hash_map.Add(key, 1);
+                if (t % 2 == 0 && round % 2 == 1) {
+                    hash_map.Erase(key);
+                }
+            }
+        }
+        });
+    const map<int, int> result = ToMap(hash_map);
+    ASSERT_EQUAL(result.size(), static_cast<size_t>(KEYS_PER_THREAD * THREAD_COUNT / 2));
+    for (const auto& [key, value] : result) {
+        ASSERT_EQUAL_HINT(key % 2, 1, to_string(key));
+        ASSERT_EQUAL_HINT(value, 20, to_string(key));
+    }
+}
+
+TEST_CASE(TestConcurrentMapErase) {
+    ConcurrentMap<int, int> concurrent_map(3);
+    for (int key = 0; key < 10; ++key) {
+        concurrent_map[key].ref_to_value = key;
+    }
+    concurrent_map.erase(4);
+    concurrent_map.erase(11);
+    const map<int, int> result = concurrent_map.BuildOrdinaryMap();
+    ASSERT_EQUAL(result.size(), 9u);
+    ASSERT(result.count(4) == 0);
+}
@@ -0,0 +1,42 @@
+#include "counting_allocator.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+namespace {
+
+    atomic<bool> is_counting_allocations = false;
+    atomic<size_t> allocation_count = 0;
+
+}
+
+void StartCountingAllocations() {
+    allocation_count = 0;
+    is_counting_allocations = true;
+}
+
+size_t StopCountingAllocations() {
+    is_counting_allocations = false;
+    return allocation_count;
+}
+
+void* operator new(size_t size) {
+    if (is_counting_allocations.load(memory_order_relaxed)) {
+        allocation_count.fetch_add(1, memory_order_relaxed);
+    }
+    if (void* memory = malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
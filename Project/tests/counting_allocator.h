@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+// counting_allocator.cpp replaces the global allocation functions with ones that can count
+// the allocations. Only binaries that link it get the replacement
+
+void StartCountingAllocations();
+
+// Allocations made by the whole binary since the counting started
+size_t StopCountingAllocations();
+
+// Allocations made by the function
+template <typename Function>
+size_t CountAllocations(Function function) {
+    StartCountingAllocations();
+    function();
+    return StopCountingAllocations();
+}
@@ -0,0 +1,153 @@
+#include <atomic>
+#include <chrono>
+#include <execution>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "process_queries.h"
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace {
+
+    // Long enough for the workers to pick up their tasks, short enough that a broken pool fails instead of hanging
+    const auto WAIT_TIMEOUT = chrono::seconds(30);
+
+    // Keeps every worker of the pool busy until destroyed, so that a task submitted to the pool
+    // meanwhile stays pending. Work that only the caller can run still completes, as ParallelFor
+    // never waits for a call that has not started
+    class PoolBlocker {
+    public:
+        explicit PoolBlocker(ThreadPool& pool)
+            : state_(make_shared<State>()) {
+            for (size_t i = 0; i < pool.GetThreadCount(); ++i) {
+                pool.Submit([state = state_] {
+                    ++state->started_count;
+                    while (!state->released) {
+                        this_thread::yield();
+                    }
+                    });
+            }
+            const auto deadline = chrono::steady_clock::now() + WAIT_TIMEOUT;
+            while (state_->started_count < pool.GetThreadCount() && chrono::steady_clock::now() < deadline) {
+                this_thread::yield();
+            }
+            if (state_->started_count < pool.GetThreadCount()) {
+                state_->released = true;
+                ASSERT_EQUAL(state_->started_count.load(), pool.GetThreadCount());
+            }
+        }
+
+        PoolBlocker(const PoolBlocker&) = delete;
+        PoolBlocker& operator=(const PoolBlocker&) = delete;
+
+        ~PoolBlocker() {
+            state_->released = true;
+        }
+
+    private:
+        // Shared with the tasks, which may still be yielding when the blocker is gone
+        struct State {
+            atomic<size_t> started_count = 0;
+            atomic<bool> released = false;
+        };
+
+        shared_ptr<State> state_;
+    };
+
+    vector<string> MakeQueries() {
+        vector<string> queries;
+        for (int i = 0; i < 200; ++i) {
+            queries.push_back("w"s + to_string(i % 40) + " w"s + to_string(i * 7 % 40) + (i % 5 == 0 ? " -w3"s : ""s));
+        }
+        return queries;
+    }
+
+    // Every parallel entry point of the server, checked against the sequential results of the expected server
+    void AssertParallelResults(SearchServer& search_server, const SearchServer& expected, const string& hint) {
+        const vector<string> queries = MakeQueries();
+        const auto results = ProcessQueries(search_server, queries);
+        ASSERT_EQUAL_HINT(results.size(), queries.size(), hint);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            AssertSameDocuments(results[i], expected.FindTopDocuments(execution::seq, queries[i]), hint + ", "s + queries[i]);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::par, queries[i]), results[i], hint + ", par "s + queries[i]);
+        }
+
+        size_t query_index = 0;
+        size_t consumed_count = 0;
+        ProcessQueriesStreamed(search_server,
+            [&queries, &query_index](string& query) {
+                if (query_index == queries.size()) {
+                    return false;
+                }
+                query = queries[query_index++];
+                return true;
+            },
+            [&results, &consumed_count, &hint](vector<Document>&& documents) {
+                AssertSameDocuments(documents, results[consumed_count], hint + ", streamed"s);
+                ++consumed_count;
+            },
+            16);
+        ASSERT_EQUAL_HINT(consumed_count, queries.size(), hint);
+    }
+
+}
+
+TEST_CASE(TestSetExecutorRunsParallelWorkOnPool) {
+    const SearchServer expected = MakeRandomSearchServer(8, 5000, 40, 7);
+    SearchServer search_server = expected;
+    ASSERT(&search_server.GetExecutor() == &ThreadPool::GetDefault());
+
+    ThreadPool pool(2);
+    search_server.SetExecutor(pool);
+    ASSERT(&search_server.GetExecutor() == &pool);
+    // Nothing reaches the default pool while the server runs on its own
+    {
+        PoolBlocker blocker(ThreadPool::GetDefault());
+        const size_t default_pending_count = ThreadPool::GetDefault().GetPendingTaskCount();
+        AssertParallelResults(search_server, expected, "custom pool"s);
+        search_server.RemoveDocument(execution::par, 3);
+        ASSERT_EQUAL(ThreadPool::GetDefault().GetPendingTaskCount(), default_pending_count);
+    }
+    ASSERT_EQUAL(search_server.GetDocumentCount(), expected.GetDocumentCount() - 1);
+}
+
+// The executor may be swapped while no parallel work runs, back and forth, without changing any result
+TEST_CASE(TestSetExecutorSwapsWhileIdle) {
+    const SearchServer expected = MakeRandomSearchServer(9, 3000, 40, 0);
+    SearchServer search_server = expected;
+    ThreadPool first_pool(1);
+    ThreadPool second_pool(3);
+
+    search_server.SetExecutor(first_pool);
+    AssertParallelResults(search_server, expected, "first pool"s);
+    search_server.SetExecutor(second_pool);
+    ASSERT(&search_server.GetExecutor() == &second_pool);
+    {
+        // The pool swapped out gets no more work
+        PoolBlocker blocker(first_pool);
+        const size_t pending_count = first_pool.GetPendingTaskCount();
+        AssertParallelResults(search_server, expected, "second pool"s);
+        ASSERT_EQUAL(first_pool.GetPendingTaskCount(), pending_count);
+    }
+
+    search_server.SetExecutor(ThreadPool::GetDefault());
+    ASSERT(&search_server.GetExecutor() == &ThreadPool::GetDefault());
+    {
+        PoolBlocker blocker(second_pool);
+        const size_t pending_count = second_pool.GetPendingTaskCount();
+        AssertParallelResults(search_server, expected, "default pool"s);
+        ASSERT_EQUAL(second_pool.GetPendingTaskCount(), pending_count);
+    }
+
+    // A copy keeps the executor of the original
+    search_server.SetExecutor(first_pool);
+    const SearchServer copy = search_server;
+    ASSERT(&copy.GetExecutor() == &first_pool);
+}
@@ -0,0 +1,109 @@
+#include <execution>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    SearchServer MakeSearchServer() {
+        return MakeRandomSearchServer(12, 4000, 60, 13);
+    }
+
+    const vector<string> QUERIES = {
+        "w0"s,
+        "w1 w2 and"s,
+        "w0 w1 w2 w3 w4 w5"s,
+        "w30 w45 w0 -w7"s,
+        "w5 w6 w7 w8 -w0 -w1"s,
+        "w59 w1000"s,
+        "w1000"s,
+    };
+
+    // Every scoring path of the server gives exactly the results of the thawed one, relevances
+    // included, so freezing only moves the TF-IDF products from query time to FreezeIndex
+    void AssertScoresLikeThawed(SearchServer& search_server, const SearchServer& thawed, const string& hint) {
+        ASSERT_HINT(!thawed.IsIndexFrozen(), hint);
+        const auto is_positive = [](int document_id, DocumentStatus status, int rating) {
+            return rating > 0;
+        };
+        SearchServer::QueryContext context;
+        for (const string& query : QUERIES) {
+            const string query_hint = hint + ", "s + query;
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED }) {
+                const vector<Document> expected = thawed.FindTopDocuments(execution::seq, query, status, 1'000'000);
+                AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, status, 1'000'000), expected, query_hint);
+                AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, status, 1'000'000), expected, query_hint + ", par"s);
+            }
+            AssertSameDocuments(search_server.FindTopDocuments(context, query, is_positive),
+                thawed.FindTopDocuments(query, is_positive), query_hint + ", predicate"s);
+
+            search_server.SetQueryMode(SearchServer::QueryMode::PRUNED);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, 20),
+                thawed.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, 20), query_hint + ", pruned"s);
+            search_server.SetQueryMode(SearchServer::QueryMode::EXHAUSTIVE);
+        }
+        const vector<string_view> queries(QUERIES.begin(), QUERIES.end());
+        const auto batch = search_server.FindTopDocumentsBatch(queries);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            AssertSameDocuments(batch[i], thawed.FindTopDocuments(QUERIES[i]), hint + ", batch "s + QUERIES[i]);
+        }
+    }
+
+}
+
+TEST_CASE(TestFrozenIndexScoresLikeThawed) {
+    const SearchServer thawed = MakeSearchServer();
+    SearchServer search_server = thawed;
+    search_server.FreezeIndex();
+    ASSERT(search_server.IsIndexFrozen());
+    AssertScoresLikeThawed(search_server, thawed, "frozen"s);
+    // Freezing twice precomputes the same scores
+    search_server.FreezeIndex();
+    AssertScoresLikeThawed(search_server, thawed, "frozen twice"s);
+}
+
+// Adding or removing a document changes the inverse document frequencies that the frozen scores
+// were computed with, so both return the index to the regular mode
+TEST_CASE(TestAddAndRemoveThawIndex) {
+    SearchServer thawed = MakeSearchServer();
+    SearchServer search_server = thawed;
+
+    search_server.FreezeIndex();
+    search_server.AddDocument(10'000, "w0 w1 w1 w59"s, DocumentStatus::ACTUAL, { 4 });
+    thawed.AddDocument(10'000, "w0 w1 w1 w59"s, DocumentStatus::ACTUAL, { 4 });
+    ASSERT(!search_server.IsIndexFrozen());
+    AssertScoresLikeThawed(search_server, thawed, "added"s);
+
+    search_server.FreezeIndex();
+    search_server.AddDocuments({ { 10'001, "w2 w3"s, DocumentStatus::BANNED, { 1 } }, { 10'002, "w0 w5"s, DocumentStatus::ACTUAL, { 2 } } });
+    thawed.AddDocuments({ { 10'001, "w2 w3"s, DocumentStatus::BANNED, { 1 } }, { 10'002, "w0 w5"s, DocumentStatus::ACTUAL, { 2 } } });
+    ASSERT(!search_server.IsIndexFrozen());
+    AssertScoresLikeThawed(search_server, thawed, "added batch"s);
+
+    search_server.FreezeIndex();
+    search_server.RemoveDocument(1);
+    thawed.RemoveDocument(1);
+    ASSERT(!search_server.IsIndexFrozen());
+    AssertScoresLikeThawed(search_server, thawed, "removed"s);
+
+    search_server.FreezeIndex();
+    search_server.RemoveDocument(execution::par, 10'000);
+    thawed.RemoveDocument(execution::par, 10'000);
+    ASSERT(!search_server.IsIndexFrozen());
+    AssertScoresLikeThawed(search_server, thawed, "removed par"s);
+
+    // Refrozen after the changes, the index scores with the new frequencies
+    search_server.FreezeIndex();
+    AssertScoresLikeThawed(search_server, thawed, "refrozen"s);
+
+    // Removing an unknown document changes nothing and keeps the index frozen
+    search_server.RemoveDocument(1);
+    ASSERT(search_server.IsIndexFrozen());
+    AssertScoresLikeThawed(search_server, thawed, "removed unknown"s);
+}
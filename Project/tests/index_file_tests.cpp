@@ -0,0 +1,194 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "index_file.h"
+#include "mapped_search_server.h"
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    const vector<string> QUERIES = {
+        "w0"s,
+        "w1 w2 w3 and"s,
+        "w0 w1 w2 w3 w4 w5 -w6"s,
+        "w10 w30 w59 -w0 -w0"s,
+        "with unknown"s,
+    };
+
+    string SaveToString(const SearchServer& search_server) {
+        ostringstream output(ios::binary);
+        search_server.Save(output);
+        return output.str();
+    }
+
+    // Writes the bytes to a temporary file, which is removed when it goes out of scope
+    class TemporaryFile {
+    public:
+        explicit TemporaryFile(const string& bytes)
+            : path_((filesystem::temp_directory_path() / "search_server_index_test.bin"s).string())
+        {
+            ofstream(path_, ios::binary).write(bytes.data(), bytes.size());
+        }
+
+        ~TemporaryFile() {
+            filesystem::remove(path_);
+        }
+
+        const string& GetPath() const {
+            return path_;
+        }
+
+    private:
+        string path_;
+    };
+
+    IndexFileHeader ReadHeader(const string& bytes) {
+        IndexFileHeader header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        return header;
+    }
+
+    string WithHeader(string bytes, const IndexFileHeader& header) {
+        memcpy(bytes.data(), &header, sizeof(header));
+        return bytes;
+    }
+
+    void AssertRejected(const string& bytes, const string& hint) {
+        const TemporaryFile file(bytes);
+        bool is_thrown = false;
+        try {
+            MappedSearchServer search_server(file.GetPath());
+        }
+        catch (const invalid_argument&) {
+            is_thrown = true;
+        }
+        ASSERT_HINT(is_thrown, hint);
+    }
+
+}
+
+TEST_CASE(TestMappedIndexMatchesSavedServer) {
+    // Removals leave erased terms, which Save skips when it renumbers the terms
+    const SearchServer expected = MakeRandomSearchServer(14, 3000, 60, 7);
+    const TemporaryFile file(SaveToString(expected));
+    const MappedSearchServer search_server(file.GetPath());
+
+    ASSERT_EQUAL(search_server.GetDocumentCount(), expected.GetDocumentCount());
+    for (const string& query : QUERIES) {
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+            AssertSameDocuments(search_server.FindTopDocuments(query, status), expected.FindTopDocuments(query, status), query);
+        }
+    }
+    for (const int document_id : { 0, 1, 2, 500, 2999, 3000 }) {
+        const string hint = "document "s + to_string(document_id);
+        const auto word_freqs = search_server.GetWordFrequencies(document_id);
+        const auto expected_word_freqs = expected.GetWordFrequencies(document_id);
+        ASSERT_EQUAL_HINT(word_freqs.size(), expected_word_freqs.size(), hint);
+        size_t i = 0;
+        for (const auto& [word, term_freq] : expected_word_freqs) {
+            ASSERT_EQUAL_HINT(word_freqs[i].first, word, hint);
+            ASSERT_EQUAL_HINT(word_freqs[i].second, term_freq, hint);
+            ++i;
+        }
+
+        const auto [words, status] = search_server.MatchDocument(QUERIES[2], document_id);
+        const auto [expected_words, expected_status] = expected.MatchDocument(QUERIES[2], document_id);
+        ASSERT_EQUAL_HINT(words.size(), expected_words.size(), hint);
+        for (size_t j = 0; j < words.size(); ++j) {
+            ASSERT_EQUAL_HINT(words[j], expected_words[j], hint);
+        }
+        ASSERT_HINT(status == expected_status, hint);
+    }
+}
+
+TEST_CASE(TestMappedIndexOfEmptyServer) {
+    const SearchServer expected("and with"s);
+    const TemporaryFile file(SaveToString(expected));
+    const MappedSearchServer search_server(file.GetPath());
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 0);
+    ASSERT(search_server.FindTopDocuments("cat"s).empty());
+}
+
+TEST_CASE(TestMappedIndexRejectsCorruptFiles) {
+    const string bytes = SaveToString(MakeRandomSearchServer(15, 200, 30, 0));
+    const IndexFileHeader header = ReadHeader(bytes);
+
+    AssertRejected(""s, "empty"s);
+    AssertRejected(bytes.substr(0, sizeof(IndexFileHeader) - 1), "shorter than the header"s);
+    AssertRejected(bytes.substr(0, bytes.size() - 8), "truncated"s);
+    AssertRejected(bytes + string(8, '\0'), "longer than its header says"s);
+
+    // Every change of the header is checked before anything past it is read
+    const vector<pair<string, function<void(IndexFileHeader&)>>> corruptions = {
+        { "magic"s, [](IndexFileHeader& h) { h.magic[0] = 'X'; } },
+        { "version"s, [](IndexFileHeader& h) { ++h.version; } },
+        { "section count"s, [](IndexFileHeader& h) { --h.section_count; } },
+        { "term count beyond the file"s, [](IndexFileHeader& h) {
+            h.sections[TERM_OFFSETS].count = h.file_size;
+            h.sections[POSTING_OFFSETS].count = h.file_size;
+            } },
+        { "huge term count"s, [](IndexFileHeader& h) {
+            h.sections[TERM_OFFSETS].count = UINT64_MAX;
+            h.sections[POSTING_OFFSETS].count = UINT64_MAX;
+            } },
+        { "no document offsets"s, [](IndexFileHeader& h) { h.sections[FORWARD_OFFSETS].count = 0; } },
+        { "section offset beyond the file"s, [](IndexFileHeader& h) { h.sections[POSTING_DOCUMENTS].offset = h.file_size + 8; } },
+        { "misaligned section"s, [](IndexFileHeader& h) { h.sections[POSTING_TERM_FREQS].offset += 4; } },
+        { "posting count of another section"s, [](IndexFileHeader& h) { ++h.sections[POSTING_DOCUMENTS].count; } },
+    };
+    for (const auto& [name, corrupt] : corruptions) {
+        IndexFileHeader corrupt_header = header;
+        corrupt(corrupt_header);
+        AssertRejected(WithHeader(bytes, corrupt_header), name);
+    }
+
+    // Posting offsets that decrease would give a posting range running past the section
+    string decreasing = bytes;
+    uint64_t* posting_offsets = reinterpret_cast<uint64_t*>(decreasing.data() + header.sections[POSTING_OFFSETS].offset);
+    posting_offsets[1] = posting_offsets[2] + 1;
+    AssertRejected(decreasing, "decreasing posting offsets"s);
+
+    // Payloads that would index past the document columns or the terms
+    const auto with_value = [&bytes, &header](IndexFileSection section, size_t index, auto value) {
+        string corrupt = bytes;
+        memcpy(corrupt.data() + header.sections[section].offset + index * sizeof(value), &value, sizeof(value));
+        return corrupt;
+    };
+    const uint64_t document_count = header.sections[FORWARD_OFFSETS].count - 1;
+    const uint64_t term_count = header.sections[TERM_OFFSETS].count - 1;
+    const uint64_t last_posting = header.sections[POSTING_DOCUMENTS].count - 1;
+    const uint64_t last_forward_entry = header.sections[FORWARD_TERMS].count - 1;
+    AssertRejected(with_value(POSTING_DOCUMENTS, 0, static_cast<int32_t>(document_count)), "posting of the document count"s);
+    AssertRejected(with_value(POSTING_DOCUMENTS, last_posting, int32_t{ -1 }), "negative posting document"s);
+    AssertRejected(with_value(FORWARD_TERMS, last_forward_entry, static_cast<uint32_t>(term_count)), "forward entry of the term count"s);
+    AssertRejected(with_value(FORWARD_TERMS, 0, UINT32_MAX), "forward entry of no term"s);
+
+    // The largest valid values are accepted
+    for (const string& valid : { with_value(POSTING_DOCUMENTS, 0, static_cast<int32_t>(document_count - 1)),
+        with_value(FORWARD_TERMS, 0, static_cast<uint32_t>(term_count - 1)) }) {
+        const TemporaryFile file(valid);
+        ASSERT_EQUAL(MappedSearchServer(file.GetPath()).GetDocumentCount(), static_cast<int>(document_count));
+    }
+}
+
+TEST_CASE(TestMappedIndexReportsMissingFile) {
+    bool is_thrown = false;
+    try {
+        MappedSearchServer search_server((filesystem::temp_directory_path() / "no_such_search_server_index.bin"s).string());
+    }
+    catch (const runtime_error&) {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+}
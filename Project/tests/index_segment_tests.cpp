@@ -0,0 +1,69 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "index_segment.h"
+#include "search_server.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    // Segment of documents first_id..first_id + document_count - 1, the first removed_count of them tombstoned
+    shared_ptr<IndexSegment> MakeSegment(int first_id, int document_count, int removed_count) {
+        auto index = make_shared<SearchServer>("and"s);
+        for (int id = first_id; id < first_id + document_count; ++id) {
+            index->AddDocument(id, "cat w"s + to_string(id % 3), DocumentStatus::ACTUAL, { 1 });
+        }
+        auto segment = make_shared<IndexSegment>(IndexSegment{ index });
+        for (int id = first_id; id < first_id + removed_count; ++id) {
+            segment->MarkRemoved(id);
+        }
+        return segment;
+    }
+
+}
+
+TEST_CASE(TestIndexSegmentTombstones) {
+    const auto segment = MakeSegment(0, 30, 10);
+    ASSERT_EQUAL(segment->GetDocumentCount(), 20);
+    ASSERT_EQUAL(segment->GetDocumentFreq("cat"s), 20);
+    // Documents 0..9 hold w0 four times, w1 and w2 three times each
+    ASSERT_EQUAL(segment->GetDocumentFreq("w0"s), 6);
+    ASSERT_EQUAL(segment->GetDocumentFreq("w1"s), 7);
+    ASSERT_EQUAL(segment->GetDocumentFreq("and"s), 0);
+    ASSERT_EQUAL(segment->FindOrdinal(5), -1);
+    ASSERT(segment->FindOrdinal(15) != -1);
+    ASSERT(IndexSegment::FindOrdinal(*segment->index, 5) != -1);
+
+    const auto merged = IndexSegment::Merge(SearchServer("and"s), { segment, MakeSegment(100, 5, 0) });
+    ASSERT_EQUAL(merged->GetDocumentCount(), 25);
+    ASSERT(merged->removed_ordinals.empty());
+    ASSERT_EQUAL(merged->GetDocumentFreq("w1"s), 9);
+    ASSERT_EQUAL(merged->FindOrdinal(5), -1);
+    ASSERT(merged->FindOrdinal(102) != -1);
+}
+
+TEST_CASE(TestTieredMergePolicy) {
+    const TieredMergePolicy policy(4);
+    vector<shared_ptr<IndexSegment>> segments;
+    ASSERT(policy.PickSegmentsToMerge(segments).empty());
+
+    // Three segments of the lowest tier and one of the next do not fill a tier
+    segments = { MakeSegment(0, 4, 0), MakeSegment(100, 16, 0), MakeSegment(200, 3, 0), MakeSegment(300, 15, 0) };
+    ASSERT(policy.PickSegmentsToMerge(segments).empty());
+    // Tombstones move a segment down by its live size
+    segments.push_back(MakeSegment(400, 20, 5));
+    ASSERT(!policy.NeedsRewrite(*segments.back()));
+    const auto sources = policy.PickSegmentsToMerge(segments);
+    ASSERT_EQUAL(sources.size(), TieredMergePolicy::MERGE_FACTOR);
+    ASSERT(sources[0] == segments[0] && sources[3] == segments[4]);
+
+    // A segment mostly of tombstones is rewritten first, on its own
+    segments.push_back(MakeSegment(500, 9, 5));
+    ASSERT(policy.NeedsRewrite(*segments.back()));
+    const auto rewritten = policy.PickSegmentsToMerge(segments);
+    ASSERT_EQUAL(rewritten.size(), 1u);
+    ASSERT(rewritten[0] == segments.back());
+}
@@ -0,0 +1,128 @@
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "search_server.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    const int DOCUMENT_COUNT = 3000;
+    // Those of the server
+    const set<string> STOP_WORDS = { "w0"s, "w1"s };
+
+    SearchServer MakeSearchServer() {
+        SearchServer search_server("w0 w1"s);
+        mt19937 generator(9);
+        for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+            string text;
+            const int word_count = 1 + generator() % 40;
+            for (int i = 0; i < word_count; ++i) {
+                text += (i == 0 ? "w"s : " w"s) + to_string(generator() % 300);
+            }
+            search_server.AddDocument(id, text, static_cast<DocumentStatus>(id % 4), { 1 });
+        }
+        for (int id = 0; id < DOCUMENT_COUNT; id += 4) {
+            search_server.RemoveDocument(id);
+        }
+        return search_server;
+    }
+
+    // Queries with repeated words, stop words as plus and minus words, and words of no document
+    vector<string> MakeQueries() {
+        vector<string> queries;
+        mt19937 generator(10);
+        for (int i = 0; i < 200; ++i) {
+            string query;
+            for (int j = 0; j < 1 + i % 12; ++j) {
+                query += (j == 0 ? ""s : " "s) + (generator() % 4 == 0 ? "-w"s : "w"s) + to_string(generator() % 320);
+            }
+            queries.push_back(query);
+        }
+        return queries;
+    }
+
+    using Match = tuple<vector<string_view>, DocumentStatus>;
+
+    // Plus words of the query in the document, by a scan of its forward index; none if it has a minus word
+    vector<string> MatchByScan(const SearchServer& search_server, const string& query, int document_id) {
+        set<string> document_words;
+        for (const auto& [word, term_freq] : search_server.GetWordFrequencies(document_id)) {
+            document_words.emplace(word);
+        }
+        set<string> plus_words;
+        size_t begin = 0;
+        while (begin < query.size()) {
+            size_t end = query.find(' ', begin);
+            end = end == string::npos ? query.size() : end;
+            const string word = query.substr(begin, end - begin);
+            begin = end + 1;
+            if (word[0] == '-') {
+                if (STOP_WORDS.count(word.substr(1)) == 0 && document_words.count(word.substr(1)) > 0) {
+                    return {};
+                }
+            }
+            else if (STOP_WORDS.count(word) == 0 && document_words.count(word) > 0) {
+                plus_words.insert(word);
+            }
+        }
+        return { plus_words.begin(), plus_words.end() };
+    }
+
+    void AssertMatch(const Match& match, const vector<string>& expected_words, DocumentStatus expected_status, const string& hint) {
+        const auto& [words, status] = match;
+        ASSERT_EQUAL_HINT(words.size(), expected_words.size(), hint);
+        for (size_t i = 0; i < words.size(); ++i) {
+            ASSERT_EQUAL_HINT(words[i], expected_words[i], hint);
+        }
+        ASSERT_EQUAL_HINT(static_cast<int>(status), static_cast<int>(expected_status), hint);
+    }
+
+}
+
+// Every match path against the scan, on live, removed and unknown documents
+TEST_CASE(TestMatchDocumentMatchesScan) {
+    const SearchServer search_server = MakeSearchServer();
+    vector<int> document_ids;
+    for (int id = 0; id < DOCUMENT_COUNT + 10; id += 3) {
+        document_ids.push_back(id);
+    }
+
+    for (const string& query : MakeQueries()) {
+        const auto matches_seq = search_server.MatchDocuments(execution::seq, query, document_ids);
+        const auto matches_par = search_server.MatchDocuments(execution::par, query, document_ids);
+        ASSERT_EQUAL(matches_seq.size(), document_ids.size());
+        ASSERT_EQUAL(matches_par.size(), document_ids.size());
+        for (size_t i = 0; i < document_ids.size(); ++i) {
+            const int document_id = document_ids[i];
+            const bool is_live = document_id < DOCUMENT_COUNT && document_id % 4 != 0;
+            const vector<string> expected_words = is_live ? MatchByScan(search_server, query, document_id) : vector<string>{};
+            // An unknown document gets a value-initialized status
+            const DocumentStatus expected_status = is_live ? static_cast<DocumentStatus>(document_id % 4) : DocumentStatus{};
+            const string hint = query + " / document "s + to_string(document_id);
+            AssertMatch(search_server.MatchDocument(execution::seq, query, document_id), expected_words, expected_status, hint);
+            AssertMatch(search_server.MatchDocument(execution::par, query, document_id), expected_words, expected_status, hint);
+            AssertMatch(matches_seq[i], expected_words, expected_status, hint);
+            AssertMatch(matches_par[i], expected_words, expected_status, hint);
+        }
+    }
+}
+
+TEST_CASE(TestMatchDocumentRejectsInvalidQuery) {
+    const SearchServer search_server = MakeSearchServer();
+    for (const string& query : { "w2 --w3"s, "w2 -"s, "w2 \x12"s }) {
+        bool is_thrown = false;
+        try {
+            search_server.MatchDocuments(execution::par, query, { 1, 2, 3 });
+        }
+        catch (const invalid_argument&) {
+            is_thrown = true;
+        }
+        ASSERT_HINT(is_thrown, query);
+    }
+}
@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <execution>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    const int DOCUMENT_COUNT = 4000;
+
+    // Words w0..w39 make long posting lists, so that parallel queries are split into parts.
+    // "rare" is in 10 documents, few enough for the sparse exclusion list, and "common" in a third of
+    // them, which takes the bitset
+    SearchServer MakeSearchServer() {
+        SearchServer search_server("and with"s);
+        mt19937 generator(42);
+        for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+            string text;
+            for (int i = 0; i < 30; ++i) {
+                text += "w"s + to_string(generator() % 40) + " "s;
+            }
+            if (id % 400 == 0) {
+                text += "rare "s;
+            }
+            if (id % 3 == 0) {
+                text += "common"s;
+            }
+            search_server.AddDocument(id, text, id % 7 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { id % 10 });
+        }
+        // Leaves erased postings in the lists of both minus words
+        for (int id = 0; id < DOCUMENT_COUNT; id += 800) {
+            search_server.RemoveDocument(id);
+        }
+        return search_server;
+    }
+
+    // Ids of the documents containing any of the words, by a scan of the forward index
+    set<int> FindDocumentsWithWords(const SearchServer& search_server, const vector<string>& words) {
+        set<int> document_ids;
+        for (const int document_id : search_server) {
+            for (const auto& [word, term_freq] : search_server.GetWordFrequencies(document_id)) {
+                if (find(words.begin(), words.end(), word) != words.end()) {
+                    document_ids.insert(document_id);
+                }
+            }
+        }
+        return document_ids;
+    }
+
+    // Compares the results of a query with minus words to those of its plus words with the documents
+    // of the minus words filtered out by a predicate
+    template <typename ExecutionPolicy>
+    void AssertMinusWordsExclude(const SearchServer& search_server, ExecutionPolicy policy, const string& plus_words,
+        const vector<string>& minus_words, DocumentStatus status) {
+        string query = plus_words;
+        for (const string& word : minus_words) {
+            query += " -"s + word;
+        }
+        const set<int> excluded = FindDocumentsWithWords(search_server, minus_words);
+        const vector<Document> expected = search_server.FindTopDocuments(policy, plus_words,
+            [&excluded, status](int document_id, DocumentStatus document_status, int) {
+                return document_status == status && excluded.count(document_id) == 0;
+            }, 100);
+        const vector<Document> actual = search_server.FindTopDocuments(policy, query, status, 100);
+
+        ASSERT_HINT(!expected.empty(), query);
+        AssertSameDocuments(actual, expected, query);
+    }
+
+    void AssertMinusWordsExclude(const SearchServer& search_server) {
+        const string plus_words = "w1 w2 w3 w4 w5 w6 w7 w8 w9 w10 w11 w12 rare"s;
+        for (const auto& minus_words : { vector{ "rare"s }, vector{ "common"s }, vector{ "rare"s, "common"s }, vector{ "w3"s } }) {
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                AssertMinusWordsExclude(search_server, execution::seq, plus_words, minus_words, status);
+                AssertMinusWordsExclude(search_server, execution::par, plus_words, minus_words, status);
+            }
+        }
+    }
+
+}
+
+TEST_CASE(TestMinusWordsExcludeDocuments) {
+    AssertMinusWordsExclude(MakeSearchServer());
+}
+
+TEST_CASE(TestMinusWordsExcludeDocumentsPruned) {
+    SearchServer search_server = MakeSearchServer();
+    search_server.SetQueryMode(SearchServer::QueryMode::PRUNED);
+    AssertMinusWordsExclude(search_server);
+}
+
+TEST_CASE(TestMinusWordsExcludeDocumentsFrozen) {
+    SearchServer search_server = MakeSearchServer();
+    search_server.FreezeIndex();
+    AssertMinusWordsExclude(search_server);
+}
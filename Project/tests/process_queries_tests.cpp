@@ -0,0 +1,126 @@
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "process_queries.h"
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    SearchServer MakeSearchServer() {
+        return MakeRandomSearchServer(5, 2000, 100, 0);
+    }
+
+    vector<string> MakeQueries() {
+        vector<string> queries;
+        mt19937 generator(6);
+        for (int i = 0; i < 300; ++i) {
+            string query;
+            for (int j = 0; j < 1 + i % 5; ++j) {
+                query += (query.empty() ? ""s : " "s) + (generator() % 8 == 0 ? "-w"s : "w"s) + to_string(generator() % 120);
+            }
+            queries.push_back(query);
+        }
+        return queries;
+    }
+
+    // Results of the queries run one by one, joined
+    vector<Document> FindJoined(const SearchServer& search_server, const vector<string>& queries) {
+        vector<Document> joined;
+        for (const string& query : queries) {
+            const vector<Document> documents = search_server.FindTopDocuments(query);
+            joined.insert(joined.end(), documents.begin(), documents.end());
+        }
+        return joined;
+    }
+
+}
+
+TEST_CASE(TestProcessQueries) {
+    const SearchServer search_server = MakeSearchServer();
+    const vector<string> queries = MakeQueries();
+    const auto results = ProcessQueries(search_server, queries);
+    ASSERT_EQUAL(results.size(), queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        AssertSameDocuments(results[i], search_server.FindTopDocuments(queries[i]));
+    }
+    ASSERT(ProcessQueries(search_server, {}).empty());
+}
+
+TEST_CASE(TestProcessQueriesJoined) {
+    const SearchServer search_server = MakeSearchServer();
+    const vector<string> queries = MakeQueries();
+    const vector<Document> expected = FindJoined(search_server, queries);
+    AssertSameDocuments(ProcessQueriesJoined(search_server, queries), expected);
+
+    vector<Document> joined;
+    ProcessQueriesJoined(search_server, queries.begin(), queries.end(), back_inserter(joined), 7);
+    AssertSameDocuments(joined, expected);
+}
+
+TEST_CASE(TestProcessQueriesStreamed) {
+    const SearchServer search_server = MakeSearchServer();
+    const vector<string> queries = MakeQueries();
+    const vector<Document> expected = FindJoined(search_server, queries);
+    string query_text;
+    for (const string& query : queries) {
+        query_text += query + "\n"s;
+    }
+
+    // Windows smaller than, equal to and larger than the input
+    for (const size_t window_size : { 1, 3, 300, 1024 }) {
+        istringstream input(query_text);
+        vector<Document> joined;
+        size_t result_count = 0;
+        ProcessQueriesStreamed(search_server, input, [&](vector<Document>&& documents) {
+            ++result_count;
+            joined.insert(joined.end(), documents.begin(), documents.end());
+            }, window_size);
+        ASSERT_EQUAL(result_count, queries.size());
+        AssertSameDocuments(joined, expected);
+    }
+
+    istringstream empty_input;
+    size_t result_count = 0;
+    ProcessQueriesStreamed(search_server, empty_input, [&result_count](vector<Document>&&) {
+        ++result_count;
+        });
+    ASSERT_EQUAL(result_count, 0u);
+}
+
+TEST_CASE(TestProcessQueriesStreamedRethrows) {
+    const SearchServer search_server = MakeSearchServer();
+    vector<string> queries = MakeQueries();
+    queries[150] = "w1 --w2"s;
+    bool is_thrown = false;
+    try {
+        ProcessQueriesStreamed(search_server, queries.begin(), queries.end(), [](vector<Document>&&) {}, 16);
+    }
+    catch (const invalid_argument&) {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+
+    // An exception of consume stops the stream
+    size_t result_count = 0;
+    is_thrown = false;
+    try {
+        ProcessQueriesStreamed(search_server, queries.begin(), queries.begin() + 100, [&result_count](vector<Document>&&) {
+            if (++result_count == 10) {
+                throw runtime_error("consume failed"s);
+            }
+            }, 16);
+    }
+    catch (const runtime_error&) {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    ASSERT_EQUAL(result_count, 10u);
+}
@@ -0,0 +1,108 @@
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "process_queries.h"
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    const int DOCUMENT_COUNT = 10'000;
+
+    // More ordinals than a batch window, so the batches span several windows. Every 50th document
+    // is replaced by one with the same text, so that their relevances tie
+    SearchServer MakeSearchServer() {
+        SearchServer search_server = MakeRandomSearchServer(3, DOCUMENT_COUNT, 50, 17);
+        for (int id = 0; id < DOCUMENT_COUNT; id += 50) {
+            search_server.RemoveDocument(id);
+            search_server.AddDocument(id, "tie tie w0"s, static_cast<DocumentStatus>(id / 50 % 4), { id / 50 % 5 });
+        }
+        return search_server;
+    }
+
+    // Queries share words; there are repeated queries, stop words, unknown words and queries with no result
+    const vector<string_view> QUERIES = {
+        "w0"sv,
+        "w0 w1 w2"sv,
+        "w2 w1 w0 w0"sv,
+        "w1 w3 -w0"sv,
+        "tie"sv,
+        "tie w0 -w1"sv,
+        "w10 w20 w30 w40 and"sv,
+        "w0"sv,
+        "w5 -w5"sv,
+        "unknown"sv,
+        "unknown -w0"sv,
+        "w45 w46 w47 w48 w49 -w1 -w2"sv,
+    };
+
+    void AssertBatchMatchesQueries(const SearchServer& search_server, const vector<string_view>& queries) {
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+            const auto results = search_server.FindTopDocumentsBatch(queries, status);
+            ASSERT_EQUAL(results.size(), queries.size());
+            for (size_t i = 0; i < queries.size(); ++i) {
+                AssertSameDocuments(results[i], search_server.FindTopDocuments(queries[i], status), string(queries[i]));
+            }
+        }
+    }
+
+}
+
+TEST_CASE(TestBatchMatchesQueries) {
+    const SearchServer search_server = MakeSearchServer();
+    AssertBatchMatchesQueries(search_server, QUERIES);
+    AssertBatchMatchesQueries(search_server, { QUERIES[1] });
+    ASSERT(search_server.FindTopDocumentsBatch({}).empty());
+}
+
+TEST_CASE(TestBatchMatchesQueriesOnFrozenIndex) {
+    SearchServer search_server = MakeSearchServer();
+    search_server.FreezeIndex();
+    AssertBatchMatchesQueries(search_server, QUERIES);
+}
+
+TEST_CASE(TestBatchMatchesQueriesOnCompressedIndex) {
+    SearchServer search_server = MakeSearchServer();
+    search_server.CompressIndex();
+    AssertBatchMatchesQueries(search_server, QUERIES);
+}
+
+// Fewer ordinals than a window, so the window shrinks to the index
+TEST_CASE(TestBatchMatchesQueriesOnSmallIndex) {
+    const SearchServer search_server = MakeExampleSearchServer();
+    AssertBatchMatchesQueries(search_server, { "fluffy groomed cat"sv, "cat -collar"sv, "groomed starling"sv, "parrot"sv });
+    const SearchServer empty_server(""s);
+    AssertBatchMatchesQueries(empty_server, QUERIES);
+}
+
+TEST_CASE(TestBatchRejectsInvalidQuery) {
+    const SearchServer search_server = MakeSearchServer();
+    bool is_thrown = false;
+    try {
+        search_server.FindTopDocumentsBatch({ "w0"sv, "w1 --w2"sv });
+    }
+    catch (const invalid_argument&) {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+}
+
+TEST_CASE(TestProcessQueriesBatched) {
+    const SearchServer search_server = MakeSearchServer();
+    // Several batches, the last one partial
+    vector<string> queries;
+    for (size_t i = 0; i < 3 * QUERY_BATCH_SIZE + 5; ++i) {
+        queries.emplace_back(QUERIES[i % QUERIES.size()]);
+    }
+    const auto expected = ProcessQueries(search_server, queries);
+    const auto actual = ProcessQueriesBatched(search_server, queries);
+    ASSERT_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        AssertSameDocuments(actual[i], expected[i], queries[i]);
+    }
+}
@@ -0,0 +1,90 @@
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    // Posting lists span many blocks, so pruning has blocks to skip
+    SearchServer MakeSearchServer() {
+        return MakeRandomSearchServer(7, 3000, 60, 11);
+    }
+
+    vector<Document> FindTopDocuments(SearchServer& search_server, SearchServer::QueryMode mode, const string& query,
+        DocumentStatus status, size_t max_count) {
+        search_server.SetQueryMode(mode);
+        return search_server.FindTopDocuments(execution::seq, query, status, max_count);
+    }
+
+    void AssertModesAgree(SearchServer& search_server, const string& query, DocumentStatus status, size_t max_count) {
+        const string hint = query + " / status "s + to_string(static_cast<int>(status)) + " / top "s + to_string(max_count);
+        const vector<Document> expected = FindTopDocuments(search_server, SearchServer::QueryMode::EXHAUSTIVE, query, status, max_count);
+        const vector<Document> actual = FindTopDocuments(search_server, SearchServer::QueryMode::PRUNED, query, status, max_count);
+        search_server.SetQueryMode(SearchServer::QueryMode::EXHAUSTIVE);
+        AssertSameDocuments(actual, expected, hint);
+    }
+
+    const vector<string> QUERIES = {
+        "w0"s,
+        "w1 w2"s,
+        "w0 w1 w2 w3 w4 w5"s,
+        "w30 w45 w0"s,
+        "w0 w1 w2 -w3"s,
+        "w5 w6 w7 w8 -w0 -w1"s,
+        "w2 w9 w17 w33 w40 w51 -w20"s,
+        "w58 w59 -w0"s,
+        "w1000"s,
+    };
+
+    void AssertModesAgree(SearchServer& search_server) {
+        for (const string& query : QUERIES) {
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                for (const size_t max_count : { 1, 5, 50 }) {
+                    AssertModesAgree(search_server, query, status, max_count);
+                }
+            }
+        }
+    }
+
+}
+
+TEST_CASE(TestPrunedMatchesExhaustive) {
+    SearchServer search_server = MakeSearchServer();
+    AssertModesAgree(search_server);
+}
+
+TEST_CASE(TestPrunedMatchesExhaustiveOnFrozenIndex) {
+    SearchServer search_server = MakeSearchServer();
+    search_server.FreezeIndex();
+    AssertModesAgree(search_server);
+}
+
+TEST_CASE(TestPrunedBreaksTiesLikeExhaustive) {
+    // All documents have the same relevance for "cat", so ratings and then ids decide
+    SearchServer search_server(""s);
+    for (int id = 0; id < 500; ++id) {
+        search_server.AddDocument(id, "cat dog"s, id % 3 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { id % 7 });
+    }
+    search_server.AddDocument(500, "bird"s, DocumentStatus::ACTUAL, { 0 });
+    for (const string& query : { "cat"s, "cat dog"s, "cat -bird"s }) {
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+            for (const size_t max_count : { 1, 5, 50 }) {
+                AssertModesAgree(search_server, query, status, max_count);
+            }
+        }
+    }
+
+    search_server.SetQueryMode(SearchServer::QueryMode::PRUNED);
+    const vector<Document> documents = search_server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(documents.size(), 5u);
+    // The first ACTUAL documents with rating 6
+    const vector<int> expected_ids = { 13, 20, 34, 41, 55 };
+    for (size_t i = 0; i < expected_ids.size(); ++i) {
+        ASSERT_EQUAL(documents[i].id, expected_ids[i]);
+        ASSERT_EQUAL(documents[i].rating, 6);
+    }
+}
@@ -0,0 +1,117 @@
+#include <string>
+#include <vector>
+
+#include "process_queries.h"
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+
+using namespace std;
+
+TEST_CASE(TestCachedResultsMatchUncached) {
+    const SearchServer uncached = MakeExampleSearchServer();
+    SearchServer cached = MakeExampleSearchServer();
+    cached.SetResultCacheCapacity(64);
+    const vector<string> queries = { "fluffy groomed cat"s, "cat -collar"s, "groomed -eyes starling"s, "parrot"s };
+    // The second pass is served from the cache
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const string& query : queries) {
+            AssertSameDocuments(cached.FindTopDocuments(query), uncached.FindTopDocuments(query), query);
+            AssertSameDocuments(cached.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                uncached.FindTopDocuments(query, DocumentStatus::BANNED), query);
+        }
+    }
+    const auto stats = cached.GetResultCacheStats();
+    ASSERT_EQUAL(stats.hit_count, 2 * queries.size());
+    ASSERT_EQUAL(stats.miss_count, 2 * queries.size());
+    ASSERT_EQUAL(stats.size, 2 * queries.size());
+}
+
+// ProcessQueries and ProcessQueriesJoined share the cache, while batches bypass it
+TEST_CASE(TestProcessQueriesShareResultCache) {
+    const SearchServer uncached = MakeExampleSearchServer();
+    SearchServer cached = MakeExampleSearchServer();
+    cached.SetResultCacheCapacity(64);
+    const vector<string> queries = { "fluffy groomed cat"s, "cat -collar"s, "groomed -eyes starling"s, "parrot"s };
+    const vector<Document> expected = ProcessQueriesJoined(uncached, queries);
+
+    AssertSameDocuments(ProcessQueriesJoined(cached, queries), expected);
+    auto stats = cached.GetResultCacheStats();
+    ASSERT_EQUAL(stats.hit_count, 0u);
+    ASSERT_EQUAL(stats.size, queries.size());
+    ProcessQueries(cached, queries);
+    AssertSameDocuments(ProcessQueriesJoined(cached, queries), expected);
+    stats = cached.GetResultCacheStats();
+    ASSERT_EQUAL(stats.hit_count, 2 * queries.size());
+    ASSERT_EQUAL(stats.miss_count, queries.size());
+
+    ProcessQueriesBatched(cached, queries);
+    stats = cached.GetResultCacheStats();
+    ASSERT_EQUAL(stats.hit_count + stats.miss_count, 3 * queries.size());
+}
+
+TEST_CASE(TestCacheKeyIsNormalizedQuery) {
+    SearchServer search_server = MakeExampleSearchServer();
+    search_server.SetResultCacheCapacity(16);
+    search_server.FindTopDocuments("fluffy cat -collar"s);
+    // Same words in another order, with a duplicate and a stop word
+    search_server.FindTopDocuments("-collar cat and fluffy cat"s);
+    search_server.FindTopDocuments(search_server.Prepare("cat fluffy -collar"s));
+    auto stats = search_server.GetResultCacheStats();
+    ASSERT_EQUAL(stats.hit_count, 2u);
+    ASSERT_EQUAL(stats.size, 1u);
+
+    // Another status or result count is another entry
+    search_server.FindTopDocuments("fluffy cat -collar"s, DocumentStatus::BANNED);
+    search_server.FindTopDocuments(execution::seq, "fluffy cat -collar"s, DocumentStatus::ACTUAL, 1);
+    stats = search_server.GetResultCacheStats();
+    ASSERT_EQUAL(stats.hit_count, 2u);
+    ASSERT_EQUAL(stats.size, 3u);
+}
+
+TEST_CASE(TestCacheIsEmptiedByIndexChanges) {
+    SearchServer search_server = MakeExampleSearchServer();
+    search_server.SetResultCacheCapacity(16);
+    ASSERT_EQUAL(search_server.FindTopDocuments("parrot"s).size(), 0u);
+    search_server.AddDocument(6, "talking parrot"s, DocumentStatus::ACTUAL, { 3 });
+    const vector<Document> documents = search_server.FindTopDocuments("parrot"s);
+    ASSERT_EQUAL(documents.size(), 1u);
+    ASSERT_EQUAL(documents[0].id, 6);
+    search_server.RemoveDocument(6);
+    ASSERT_EQUAL(search_server.FindTopDocuments("parrot"s).size(), 0u);
+    ASSERT_EQUAL(search_server.GetResultCacheStats().hit_count, 0u);
+}
+
+TEST_CASE(TestCacheEvictsLeastRecentlyUsed) {
+    SearchServer search_server = MakeExampleSearchServer();
+    search_server.SetResultCacheCapacity(2);
+    search_server.FindTopDocuments("cat"s);
+    search_server.FindTopDocuments("dog"s);
+    // Makes "dog" the least recently used
+    search_server.FindTopDocuments("cat"s);
+    search_server.FindTopDocuments("tail"s);
+    ASSERT_EQUAL(search_server.GetResultCacheStats().size, 2u);
+    search_server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(search_server.GetResultCacheStats().hit_count, 2u);
+    search_server.FindTopDocuments("dog"s);
+    ASSERT_EQUAL(search_server.GetResultCacheStats().hit_count, 2u);
+}
+
+TEST_CASE(TestCachedProcessQueries) {
+    const SearchServer uncached = MakeExampleSearchServer();
+    SearchServer cached = MakeExampleSearchServer();
+    cached.SetResultCacheCapacity(256);
+    vector<string> queries;
+    for (int i = 0; i < 200; ++i) {
+        queries.push_back(vector{ "fluffy groomed cat"s, "cat -collar"s, "groomed -eyes starling"s, "tail"s }[i % 4]);
+    }
+    const auto expected = ProcessQueries(uncached, queries);
+    const auto actual = ProcessQueries(cached, queries);
+    ASSERT_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        AssertSameDocuments(actual[i], expected[i], queries[i]);
+    }
+    const auto stats = cached.GetResultCacheStats();
+    ASSERT_EQUAL(stats.hit_count + stats.miss_count, queries.size());
+    ASSERT_EQUAL(stats.size, 4u);
+}
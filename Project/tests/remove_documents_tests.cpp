@@ -0,0 +1,126 @@
+#include <execution>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+
+using namespace std;
+
+struct SearchServerTestAccess {
+    static size_t GetTermCount(const SearchServer& search_server) {
+        return search_server.terms_.size();
+    }
+
+    static size_t GetOrdinalCount(const SearchServer& search_server) {
+        return search_server.ordinal_to_document_id_.size();
+    }
+};
+
+namespace {
+
+    // Common and rare words, the stop word and minus words
+    const vector<string> QUERIES = {
+        "w0"s,
+        "w1 w2 w3 and"s,
+        "w0 w1 w2 w3 w4 w5 -w6"s,
+        "w10 w20 w29 -w0 -w1"s,
+        "u7 u100 u399 w4"s,
+    };
+
+    const size_t ID_COUNT = 400;
+
+    // Shared words w0..w29, skewed towards w0, and a word u<id> of the document alone,
+    // whose term goes away with the document
+    string MakeText(mt19937& generator, int document_id) {
+        string text = "u"s + to_string(document_id);
+        const int word_count = generator() % 12;
+        for (int i = 0; i < word_count; ++i) {
+            text += " w"s + to_string(generator() % 30 * (generator() % 30) / 30);
+        }
+        if (generator() % 5 == 0) {
+            text += " and"s;
+        }
+        return text;
+    }
+
+    void AssertSameAsReference(const SearchServer& search_server, const ReferenceSearchIndex& reference, const string& hint) {
+        for (const string& query : QUERIES) {
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED }) {
+                // No bound on the result count, so that ties do not decide which documents are returned
+                AssertMatchesReference(search_server.FindTopDocuments(execution::seq, query, status, ID_COUNT),
+                    reference.FindAllDocuments(query, status), hint + ", "s + query);
+            }
+        }
+        for (const int document_id : search_server) {
+            const auto expected_word_freqs = reference.GetWordFrequencies(document_id);
+            const auto word_freqs = search_server.GetWordFrequencies(document_id);
+            ASSERT_EQUAL_HINT(word_freqs.size(), expected_word_freqs.size(), hint);
+            for (const auto& [word, term_freq] : word_freqs) {
+                ASSERT_HINT(abs(term_freq - expected_word_freqs.at(string(word))) < 1e-12, hint);
+            }
+        }
+        ASSERT_EQUAL_HINT(SearchServerTestAccess::GetTermCount(search_server), reference.GetWords().size(), hint);
+    }
+
+}
+
+// Documents are removed and added again at random, through every RemoveDocument overload
+TEST_CASE(TestRemoveDocumentChurnMatchesReference) {
+    SearchServer search_server("and with"s);
+    ReferenceSearchIndex reference({ "and"s, "with"s });
+    mt19937 generator(4);
+    size_t max_document_count = 0;
+    for (int step = 0; step < 6000; ++step) {
+        const int document_id = static_cast<int>(generator() % ID_COUNT);
+        if (reference.HasDocument(document_id)) {
+            switch (step % 3) {
+            case 0:
+                search_server.RemoveDocument(document_id);
+                break;
+            case 1:
+                search_server.RemoveDocument(execution::seq, document_id);
+                break;
+            default:
+                search_server.RemoveDocument(execution::par, document_id);
+            }
+            reference.RemoveDocument(document_id);
+        }
+        else {
+            const string text = MakeText(generator, document_id);
+            const auto status = static_cast<DocumentStatus>(generator() % 3);
+            const vector<int> ratings = { static_cast<int>(generator() % 20) - 10, static_cast<int>(generator() % 10) };
+            search_server.AddDocument(document_id, text, status, ratings);
+            reference.AddDocument(document_id, text, status, ratings);
+        }
+        max_document_count = max<size_t>(max_document_count, search_server.GetDocumentCount());
+        if (step % 500 == 0) {
+            AssertSameAsReference(search_server, reference, "step "s + to_string(step));
+        }
+    }
+    AssertSameAsReference(search_server, reference, "end"s);
+    // Freed ordinals are taken again before new ones are added
+    ASSERT_EQUAL(SearchServerTestAccess::GetOrdinalCount(search_server), max_document_count);
+
+    // Removing every document leaves no term behind
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+    for (const int document_id : document_ids) {
+        search_server.RemoveDocument(execution::par, document_id);
+        reference.RemoveDocument(document_id);
+    }
+    AssertSameAsReference(search_server, reference, "emptied"s);
+    ASSERT_EQUAL(SearchServerTestAccess::GetTermCount(search_server), 0u);
+    ASSERT(search_server.FindTopDocuments("w0"s).empty());
+}
+
+TEST_CASE(TestRemoveUnknownDocumentChangesNothing) {
+    SearchServer search_server = MakeExampleSearchServer();
+    const uint64_t generation = search_server.GetGeneration();
+    search_server.RemoveDocument(6);
+    search_server.RemoveDocument(execution::seq, -1);
+    search_server.RemoveDocument(execution::par, 100);
+    ASSERT_EQUAL(search_server.GetGeneration(), generation);
+    AssertSameIndex(search_server, MakeExampleSearchServer(), { "fluffy groomed cat"s, "starling -cat"s });
+}
@@ -0,0 +1,166 @@
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "request_queue.h"
+#include "search_server.h"
+#include "test_framework.h"
+
+using namespace std;
+
+struct RequestQueueTestAccess {
+    static void SetNextSequence(RequestQueue& request_queue, uint64_t sequence) {
+        request_queue.next_sequence_ = sequence;
+    }
+};
+
+namespace {
+
+    struct WindowRequest {
+        bool no_result;
+        uint64_t latency_us;
+    };
+
+}
+
+TEST_CASE(TestRequestQueueMatchesWindow) {
+    const SearchServer search_server(""s);
+    for (const size_t capacity : { 1, 3, 7, 1440 }) {
+        RequestQueue request_queue(search_server, capacity);
+        deque<WindowRequest> window;
+        mt19937 generator(static_cast<unsigned>(capacity));
+        for (int i = 0; i < 5000; ++i) {
+            const size_t result_count = generator() % 3;
+            const uint64_t latency_us = generator() % 1000;
+            request_queue.Record(result_count, chrono::microseconds(latency_us));
+            window.push_back({ result_count == 0, latency_us });
+            if (window.size() > capacity) {
+                window.pop_front();
+            }
+
+            size_t no_result_count = 0;
+            uint64_t total_latency_us = 0;
+            for (const WindowRequest& request : window) {
+                no_result_count += request.no_result;
+                total_latency_us += request.latency_us;
+            }
+            const RequestQueue::Stats stats = request_queue.GetStats();
+            const string hint = "capacity "s + to_string(capacity) + ", request "s + to_string(i);
+            ASSERT_EQUAL_HINT(stats.total_request_count, static_cast<uint64_t>(i + 1), hint);
+            ASSERT_EQUAL_HINT(stats.request_count, window.size(), hint);
+            ASSERT_EQUAL_HINT(stats.no_result_count, no_result_count, hint);
+            ASSERT_EQUAL_HINT(stats.hit_count, window.size() - no_result_count, hint);
+            ASSERT_EQUAL_HINT(stats.total_latency_us, total_latency_us, hint);
+        }
+    }
+}
+
+TEST_CASE(TestRequestQueueKeepsWindowAcrossSequenceWraparound) {
+    // The sequence field of a slot holds 40 bits, so it wraps around within these requests
+    const SearchServer search_server(""s);
+    static constexpr size_t CAPACITY = 7;
+    RequestQueue request_queue(search_server, CAPACITY);
+    RequestQueueTestAccess::SetNextSequence(request_queue, (uint64_t{ 1 } << 40) - 100);
+    // Fills the window with no-result requests before the wraparound
+    for (size_t i = 0; i < CAPACITY; ++i) {
+        request_queue.Record(0, chrono::microseconds(10));
+    }
+    for (int i = 0; i < 200; ++i) {
+        request_queue.Record(i % 2, chrono::microseconds(i));
+    }
+    // The last 7 requests were 193..199, of which the even ones found nothing
+    const RequestQueue::Stats stats = request_queue.GetStats();
+    ASSERT_EQUAL(stats.request_count, CAPACITY);
+    ASSERT_EQUAL(stats.no_result_count, 3u);
+    ASSERT_EQUAL(stats.total_latency_us, 193u + 194 + 195 + 196 + 197 + 198 + 199);
+}
+
+TEST_CASE(TestRequestQueueEvictsNoResultRequests) {
+    // Every eviction subtracts from the packed counters, so the window must come back to zero
+    const SearchServer search_server(""s);
+    RequestQueue request_queue(search_server, 5);
+    for (int i = 0; i < 100'000; ++i) {
+        request_queue.Record(0, chrono::microseconds(i % 2 == 0 ? 0 : 1000));
+    }
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 5);
+    for (int i = 0; i < 5; ++i) {
+        request_queue.Record(1, chrono::microseconds(0));
+    }
+    const RequestQueue::Stats stats = request_queue.GetStats();
+    ASSERT_EQUAL(stats.no_result_count, 0u);
+    ASSERT_EQUAL(stats.total_latency_us, 0u);
+}
+
+TEST_CASE(TestRequestQueueClampsLatency) {
+    const SearchServer search_server(""s);
+    RequestQueue request_queue(search_server, 4);
+    request_queue.Record(0, chrono::hours(1));
+    request_queue.Record(0, chrono::microseconds(-5));
+    const RequestQueue::Stats stats = request_queue.GetStats();
+    ASSERT(stats.total_latency_us > 0u && stats.total_latency_us < 3'600'000'000u);
+    ASSERT_EQUAL(stats.no_result_count, 2u);
+}
+
+TEST_CASE(TestRequestQueueConcurrentRecords) {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+    static constexpr size_t CAPACITY = 100;
+    static constexpr int THREAD_COUNT = 8;
+    static constexpr int RECORD_COUNT = 20'000;
+    RequestQueue request_queue(search_server, CAPACITY);
+    vector<thread> threads;
+    for (int t = 0; t < THREAD_COUNT; ++t) {
+        threads.emplace_back([&request_queue] {
+            for (int i = 0; i < RECORD_COUNT; ++i) {
+                if (i % 100 == 0) {
+                    request_queue.AddFindRequest(i % 200 == 0 ? "cat"s : "dog"s);
+                }
+                else {
+                    request_queue.Record(0, chrono::microseconds(7));
+                }
+                request_queue.GetStats();
+            }
+            });
+    }
+    for (thread& thread : threads) {
+        thread.join();
+    }
+    // Which requests end up in the window depends on the interleaving
+    const RequestQueue::Stats stats = request_queue.GetStats();
+    ASSERT_EQUAL(stats.total_request_count, static_cast<uint64_t>(THREAD_COUNT * RECORD_COUNT));
+    ASSERT_EQUAL(stats.request_count, CAPACITY);
+    ASSERT(stats.no_result_count <= CAPACITY);
+}
+
+TEST_CASE(TestRequestQueueRejectsLargeCapacity) {
+    const SearchServer search_server(""s);
+    RequestQueue request_queue(search_server, RequestQueue::MAX_CAPACITY);
+    request_queue.Record(0, chrono::microseconds(1));
+    ASSERT_EQUAL(request_queue.GetStats().no_result_count, 1u);
+    try {
+        RequestQueue too_large(search_server, RequestQueue::MAX_CAPACITY + 1);
+        ASSERT_HINT(false, "expected invalid_argument"s);
+    }
+    catch (const invalid_argument&) {
+    }
+}
+
+TEST_CASE(TestRequestQueueStatusRequestsUseResultCache) {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(2, "black cat"s, DocumentStatus::BANNED, { 2 });
+    search_server.SetResultCacheCapacity(4);
+    RequestQueue request_queue(search_server, 4);
+    for (int pass = 0; pass < 2; ++pass) {
+        const vector<Document> documents = request_queue.AddFindRequest("cat"s, DocumentStatus::BANNED);
+        ASSERT_EQUAL(documents.size(), 1u);
+        ASSERT_EQUAL(documents[0].id, 2);
+    }
+    ASSERT_EQUAL(search_server.GetResultCacheStats().hit_count, 1u);
+    ASSERT_EQUAL(request_queue.GetStats().total_request_count, 2u);
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+#include "test_framework.h"
+#include "top_documents.h"
+
+// Servers and assertions shared by the test files
+
+// Documents 0..document_count-1 of 1 to 20 words w0..w<vocabulary_size - 1>, skewed so that a few words
+// are in most documents and posting lists span many blocks. Statuses and ratings, some negative, are random.
+// Every remove_step-th document from 0 is removed, leaving erased postings; 0 removes none
+inline SearchServer MakeRandomSearchServer(unsigned seed, int document_count, int vocabulary_size, int remove_step) {
+    using namespace std::literals;
+
+    SearchServer search_server("and with"s);
+    std::mt19937 generator(seed);
+    for (int id = 0; id < document_count; ++id) {
+        std::string text;
+        const int word_count = 1 + generator() % 20;
+        for (int i = 0; i < word_count; ++i) {
+            const int word = generator() % vocabulary_size * (generator() % vocabulary_size) / vocabulary_size;
+            text += (i == 0 ? "w"s : " w"s) + std::to_string(word);
+        }
+        search_server.AddDocument(id, text, static_cast<DocumentStatus>(generator() % 4), { static_cast<int>(generator() % 10) - 3 });
+    }
+    for (int id = 0; remove_step > 0 && id < document_count; id += remove_step) {
+        search_server.RemoveDocument(id);
+    }
+    return search_server;
+}
+
+// Five short documents of every status but REMOVED, with a stop word and repeated words
+inline SearchServer MakeExampleSearchServer() {
+    using namespace std::literals;
+
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    search_server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    search_server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+    search_server.AddDocument(4, "groomed starling eugene"s, DocumentStatus::BANNED, { 9 });
+    search_server.AddDocument(5, "fluffy groomed cat with long tail"s, DocumentStatus::IRRELEVANT, { 1, 1 });
+    return search_server;
+}
+
+// Same documents in the same order, with exactly the same relevances and ratings
+inline void AssertSameDocuments(const std::vector<Document>& actual, const std::vector<Document>& expected, const std::string& hint = {}) {
+    ASSERT_EQUAL_HINT(actual.size(), expected.size(), hint);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQUAL_HINT(actual[i].id, expected[i].id, hint);
+        ASSERT_EQUAL_HINT(actual[i].relevance, expected[i].relevance, hint);
+        ASSERT_EQUAL_HINT(actual[i].rating, expected[i].rating, hint);
+    }
+}
+
+// Same documents with the same words, and the same results of the queries for every status
+inline void AssertSameIndex(const SearchServer& actual, const SearchServer& expected, const std::vector<std::string>& queries,
+    const std::string& hint = {}) {
+    using namespace std::literals;
+
+    ASSERT_EQUAL_HINT(actual.GetDocumentCount(), expected.GetDocumentCount(), hint);
+    ASSERT_HINT(std::equal(actual.begin(), actual.end(), expected.begin(), expected.end()), hint);
+    for (const int document_id : expected) {
+        const auto word_freqs = actual.GetWordFrequencies(document_id);
+        const auto expected_word_freqs = expected.GetWordFrequencies(document_id);
+        ASSERT_HINT(std::equal(word_freqs.begin(), word_freqs.end(), expected_word_freqs.begin(), expected_word_freqs.end()),
+            hint + ", document "s + std::to_string(document_id));
+    }
+    for (const std::string& query : queries) {
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED }) {
+            AssertSameDocuments(actual.FindTopDocuments(query, status), expected.FindTopDocuments(query, status), hint + ", "s + query);
+        }
+    }
+}
+
+// Brute-force TF-IDF over the plain words of every document, sharing nothing with the index
+// structures of the servers. Queries must be valid
+class ReferenceSearchIndex {
+public:
+    explicit ReferenceSearchIndex(std::set<std::string> stop_words)
+        : stop_words_(std::move(stop_words)) {
+    }
+
+    void AddDocument(int document_id, const std::string& text, DocumentStatus status, const std::vector<int>& ratings) {
+        ReferenceDocument& document = documents_[document_id];
+        document.status = status;
+        int rating_sum = 0;
+        for (const int rating : ratings) {
+            rating_sum += rating;
+        }
+        document.rating = ratings.empty() ? 0 : rating_sum / static_cast<int>(ratings.size());
+        for (const std::string& word : SplitIntoWords(text)) {
+            if (stop_words_.count(word) == 0) {
+                document.words.push_back(word);
+            }
+        }
+    }
+
+    void RemoveDocument(int document_id) {
+        documents_.erase(document_id);
+    }
+
+    bool HasDocument(int document_id) const {
+        return documents_.count(document_id) > 0;
+    }
+
+    // Term frequency of every word of the document
+    std::map<std::string, double> GetWordFrequencies(int document_id) const {
+        std::map<std::string, double> word_freqs;
+        const std::vector<std::string>& words = documents_.at(document_id).words;
+        for (const std::string& word : words) {
+            word_freqs[word] = static_cast<double>(std::count(words.begin(), words.end(), word)) / words.size();
+        }
+        return word_freqs;
+    }
+
+    // Distinct words of all documents
+    std::set<std::string> GetWords() const {
+        std::set<std::string> words;
+        for (const auto& [document_id, document] : documents_) {
+            words.insert(document.words.begin(), document.words.end());
+        }
+        return words;
+    }
+
+    // Every document of the status with a plus word and no minus word, in id order
+    std::vector<Document> FindAllDocuments(const std::string& raw_query, DocumentStatus status) const {
+        std::set<std::string> plus_words;
+        std::set<std::string> minus_words;
+        for (const std::string& word : SplitIntoWords(raw_query)) {
+            const bool is_minus = word[0] == '-';
+            const std::string text = is_minus ? word.substr(1) : word;
+            if (stop_words_.count(text) == 0) {
+                (is_minus ? minus_words : plus_words).insert(text);
+            }
+        }
+
+        std::vector<Document> result;
+        for (const auto& [document_id, document] : documents_) {
+            if (document.status != status || HasAnyWord(document, minus_words)) {
+                continue;
+            }
+            double relevance = 0.0;
+            bool has_plus_word = false;
+            for (const std::string& word : plus_words) {
+                const auto term_count = std::count(document.words.begin(), document.words.end(), word);
+                if (term_count == 0) {
+                    continue;
+                }
+                int document_freq = 0;
+                for (const auto& [other_id, other] : documents_) {
+                    document_freq += HasAnyWord(other, { word });
+                }
+                relevance += static_cast<double>(term_count) / document.words.size() * std::log(static_cast<double>(documents_.size()) / document_freq);
+                has_plus_word = true;
+            }
+            if (has_plus_word) {
+                result.push_back({ document_id, relevance, document.rating });
+            }
+        }
+        return result;
+    }
+
+private:
+    struct ReferenceDocument {
+        std::vector<std::string> words;
+        DocumentStatus status = DocumentStatus::ACTUAL;
+        int rating = 0;
+    };
+
+    std::set<std::string> stop_words_;
+    std::map<int, ReferenceDocument> documents_;
+
+    static std::vector<std::string> SplitIntoWords(const std::string& text) {
+        std::vector<std::string> words;
+        std::istringstream input(text);
+        for (std::string word; input >> word;) {
+            words.push_back(word);
+        }
+        return words;
+    }
+
+    static bool HasAnyWord(const ReferenceDocument& document, const std::set<std::string>& words) {
+        return std::any_of(document.words.begin(), document.words.end(), [&words](const std::string& word) {
+            return words.count(word) > 0;
+            });
+    }
+};
+
+// The documents of the reference, in the order of TopDocuments, with relevances equal up to rounding
+inline void AssertMatchesReference(const std::vector<Document>& actual, const std::vector<Document>& expected, const std::string& hint = {}) {
+    using namespace std::literals;
+
+    ASSERT_EQUAL_HINT(actual.size(), expected.size(), hint);
+    ASSERT_HINT(std::is_sorted(actual.begin(), actual.end(), TopDocuments::IsBetter), hint);
+    std::map<int, Document> expected_by_id;
+    for (const Document& document : expected) {
+        expected_by_id.emplace(document.id, document);
+    }
+    for (const Document& document : actual) {
+        const std::string document_hint = hint + ", document "s + std::to_string(document.id);
+        const auto it = expected_by_id.find(document.id);
+        ASSERT_HINT(it != expected_by_id.end(), document_hint);
+        ASSERT_HINT(std::abs(document.relevance - it->second.relevance) < 1e-12, document_hint);
+        ASSERT_EQUAL_HINT(document.rating, it->second.rating, document_hint);
+    }
+}
@@ -0,0 +1,211 @@
+#include <atomic>
+#include <execution>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "segmented_search_server.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    // Small segments, so that a few thousand documents give many merges
+    const size_t MAX_MUTABLE_DOCUMENT_COUNT = 64;
+
+    // With repeated words, stop words, minus words and unknown words
+    const vector<string> QUERIES = {
+        "w0"s,
+        "w1 w2 w3"s,
+        "w3 w2 w1 w1 and"s,
+        "w0 w1 w2 w3 w4 w5 -w6"s,
+        "w20 w35 w49 -w0 -w0"s,
+        "unknown -w1"s,
+    };
+
+    string MakeText(mt19937& generator) {
+        string text;
+        const int word_count = 1 + generator() % 12;
+        for (int i = 0; i < word_count; ++i) {
+            text += (i == 0 ? "w"s : " w"s) + to_string(generator() % 50 * (generator() % 50) / 50);
+        }
+        return text;
+    }
+
+    void AssertSameAsServer(const SegmentedSearchServer& segmented, const SearchServer& expected, const string& hint) {
+        ASSERT_EQUAL_HINT(segmented.GetDocumentCount(), expected.GetDocumentCount(), hint);
+        for (const string& query : QUERIES) {
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                AssertSameDocuments(segmented.FindTopDocuments(query, status), expected.FindTopDocuments(query, status), hint + " / "s + query);
+            }
+        }
+    }
+
+}
+
+// Results must not depend on how the documents are spread over segments, whether or not a merge is running
+TEST_CASE(TestSegmentedMatchesSearchServer) {
+    SegmentedSearchServer segmented("and with"s, MAX_MUTABLE_DOCUMENT_COUNT);
+    SearchServer expected("and with"s);
+    mt19937 generator(13);
+    vector<int> live_ids;
+    for (int id = 0; id < 4000; ++id) {
+        const string text = MakeText(generator);
+        const auto status = static_cast<DocumentStatus>(generator() % 4);
+        const int rating = static_cast<int>(generator() % 10) - 3;
+        segmented.AddDocument(id, text, status, { rating });
+        expected.AddDocument(id, text, status, { rating });
+        live_ids.push_back(id);
+        // Removals from sealed segments leave tombstones, and enough of them get a segment rewritten
+        if (generator() % 3 == 0) {
+            const size_t position = generator() % live_ids.size();
+            segmented.RemoveDocument(live_ids[position]);
+            expected.RemoveDocument(live_ids[position]);
+            live_ids[position] = live_ids.back();
+            live_ids.pop_back();
+        }
+        if (id % 250 == 0) {
+            AssertSameAsServer(segmented, expected, "document "s + to_string(id));
+        }
+    }
+
+    segmented.Flush();
+    AssertSameAsServer(segmented, expected, "flushed"s);
+    // 63 sealed segments of 64 documents were merged in tiers of four
+    ASSERT(segmented.GetSegmentCount() < 16);
+
+    for (const int id : { live_ids[0], live_ids[live_ids.size() / 2], live_ids.back() }) {
+        const string query = "w0 w1 w2 w3 w4 -w40"s;
+        const auto [words, status] = segmented.MatchDocument(query, id);
+        const auto [expected_words, expected_status] = expected.MatchDocument(query, id);
+        ASSERT_EQUAL(words.size(), expected_words.size());
+        for (size_t i = 0; i < words.size(); ++i) {
+            ASSERT_EQUAL(words[i], expected_words[i]);
+        }
+        ASSERT(status == expected_status);
+    }
+}
+
+// The policy overloads and the status pushdown give the results of the predicate overload and of SearchServer
+TEST_CASE(TestSegmentedPolicyAndStatusOverloads) {
+    SegmentedSearchServer segmented("and with"s, MAX_MUTABLE_DOCUMENT_COUNT);
+    SearchServer expected("and with"s);
+    mt19937 generator(15);
+    for (int id = 0; id < 1000; ++id) {
+        const string text = MakeText(generator);
+        const auto status = static_cast<DocumentStatus>(generator() % 4);
+        const int rating = static_cast<int>(generator() % 10) - 3;
+        segmented.AddDocument(id, text, status, { rating });
+        expected.AddDocument(id, text, status, { rating });
+        // Tombstones in sealed segments and removals from the mutable one
+        if (id % 7 == 3) {
+            segmented.RemoveDocument(id - 3);
+            expected.RemoveDocument(id - 3);
+        }
+    }
+
+    for (const string& query : QUERIES) {
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED }) {
+            const auto expected_documents = expected.FindTopDocuments(query, status);
+            const auto is_status = [status](int document_id, DocumentStatus document_status, int rating) {
+                return document_status == status;
+            };
+            AssertSameDocuments(segmented.FindTopDocuments(execution::seq, query, status), expected_documents, query);
+            AssertSameDocuments(segmented.FindTopDocuments(execution::par, query, status), expected_documents, query);
+            AssertSameDocuments(segmented.FindTopDocuments(query, is_status), expected_documents, query);
+            AssertSameDocuments(segmented.FindTopDocuments(execution::par, query, is_status), expected_documents, query);
+        }
+        const auto has_even_id = [](int document_id, DocumentStatus status, int rating) {
+            return document_id % 2 == 0;
+        };
+        AssertSameDocuments(segmented.FindTopDocuments(execution::par, query), expected.FindTopDocuments(query), query);
+        AssertSameDocuments(segmented.FindTopDocuments(execution::par, query, has_even_id, 20),
+            expected.FindTopDocuments(execution::seq, query, has_even_id, 20), query);
+    }
+}
+
+TEST_CASE(TestSegmentedParsesQueriesLikeSearchServer) {
+    SegmentedSearchServer segmented("and with"s);
+    SearchServer expected("and with"s);
+    segmented.AddDocument(1, "white cat and collar"s, DocumentStatus::ACTUAL, { 1 });
+    expected.AddDocument(1, "white cat and collar"s, DocumentStatus::ACTUAL, { 1 });
+    for (const string& query : { "cat --collar"s, "cat -"s, "cat \x12"s, "cat  dog"s }) {
+        bool is_thrown = false;
+        try {
+            segmented.FindTopDocuments(query);
+        }
+        catch (const invalid_argument&) {
+            is_thrown = true;
+        }
+        bool is_expected_thrown = false;
+        try {
+            expected.FindTopDocuments(query);
+        }
+        catch (const invalid_argument&) {
+            is_expected_thrown = true;
+        }
+        ASSERT_EQUAL_HINT(is_thrown, is_expected_thrown, query);
+    }
+    const string query = "white cat cat and -dog -dog"s;
+    const auto [words, status] = segmented.MatchDocument(query, 1);
+    ASSERT_EQUAL(words.size(), 2u);
+    ASSERT_EQUAL(words[0], "cat"sv);
+    ASSERT_EQUAL(words[1], "white"sv);
+}
+
+// Queries run under the shared lock while the merger rewrites segments and moves document locations.
+// The anchor documents are never removed and only differ in rating, so every query for them has
+// the same answer whichever segments hold them
+TEST_CASE(TestSegmentedQueriesDuringMerges) {
+    static constexpr int ANCHOR_COUNT = 20;
+    SegmentedSearchServer segmented("and with"s, MAX_MUTABLE_DOCUMENT_COUNT);
+    for (int id = 0; id < ANCHOR_COUNT; ++id) {
+        segmented.AddDocument(id, "anchor"s, DocumentStatus::ACTUAL, { id });
+    }
+
+    atomic<bool> is_writing = true;
+    thread writer([&segmented, &is_writing] {
+        mt19937 generator(14);
+        for (int id = ANCHOR_COUNT; id < 3000; ++id) {
+            segmented.AddDocument(id, MakeText(generator), DocumentStatus::ACTUAL, { 0 });
+            if (id % 2 == 1) {
+                segmented.RemoveDocument(id - 1 - static_cast<int>(generator() % (id - ANCHOR_COUNT)));
+            }
+        }
+        is_writing = false;
+        });
+
+    vector<thread> readers;
+    atomic<int> failure_count = 0;
+    for (int t = 0; t < 2; ++t) {
+        readers.emplace_back([&] {
+            const string query = "anchor -w0"s;
+            do {
+                const vector<Document> documents = segmented.FindTopDocuments(query);
+                bool is_correct = documents.size() == MAX_RESULT_DOCUMENT_COUNT;
+                for (size_t i = 0; is_correct && i < documents.size(); ++i) {
+                    is_correct = documents[i].id == ANCHOR_COUNT - 1 - static_cast<int>(i);
+                }
+                const auto [words, status] = segmented.MatchDocument(query, static_cast<int>(documents.size()));
+                is_correct = is_correct && words.size() == 1 && words[0] == "anchor"sv;
+                failure_count += !is_correct;
+                // Leaves the writer and the merger room on few cores
+                this_thread::yield();
+            } while (is_writing);
+            });
+    }
+    writer.join();
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQUAL(failure_count.load(), 0);
+
+    segmented.Flush();
+    ASSERT_EQUAL(segmented.FindTopDocuments("anchor"s).size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+}
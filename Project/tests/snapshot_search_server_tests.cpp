@@ -0,0 +1,156 @@
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "snapshot_search_server.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    const vector<string> QUERIES = {
+        "w0"s,
+        "w1 w2 w3"s,
+        "w0 w1 w2 w3 w4 w5 -w6"s,
+        "w20 w35 w49 -w0"s,
+        "w7 w7 and -w1 -w2"s,
+        "unknown"s,
+    };
+
+    string MakeText(mt19937& generator) {
+        string text;
+        const int word_count = 1 + generator() % 12;
+        for (int i = 0; i < word_count; ++i) {
+            text += (i == 0 ? "w"s : " w"s) + to_string(generator() % 50 * (generator() % 50) / 50);
+        }
+        return text;
+    }
+
+    void AssertSameAsServer(const SnapshotSearchServer::Snapshot& snapshot, const SearchServer& expected, const string& hint) {
+        ASSERT_EQUAL_HINT(snapshot.GetDocumentCount(), expected.GetDocumentCount(), hint);
+        for (const string& query : QUERIES) {
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                AssertSameDocuments(snapshot.FindTopDocuments(query, status), expected.FindTopDocuments(query, status), hint + " / "s + query);
+                AssertSameDocuments(snapshot.FindTopDocuments(execution::par, query, status),
+                    expected.FindTopDocuments(query, status), hint + " / "s + query);
+            }
+        }
+    }
+
+}
+
+// Adds and removes in commits of several sizes, so that open segments are sealed, sealed segments
+// get tombstones and are rewritten, and full tiers are merged. Every generation must give the results
+// of a SearchServer fed the same changes
+TEST_CASE(TestSnapshotMatchesSearchServer) {
+    SnapshotSearchServer snapshot_server("and with"s);
+    SearchServer expected("and with"s);
+    mt19937 generator(12);
+    vector<int> live_ids;
+    int next_id = 0;
+    size_t max_segment_count = 0;
+    for (int commit = 0; commit < 40; ++commit) {
+        const int add_count = commit % 3 == 0 ? 700 : 1 + generator() % 100;
+        for (int i = 0; i < add_count; ++i) {
+            const string text = MakeText(generator);
+            const auto status = static_cast<DocumentStatus>(generator() % 4);
+            const int rating = static_cast<int>(generator() % 10) - 3;
+            snapshot_server.AddDocument(next_id, text, status, { rating });
+            expected.AddDocument(next_id, text, status, { rating });
+            live_ids.push_back(next_id++);
+        }
+        // Bursts of removals from old documents give sealed segments more tombstones than they may keep
+        const int remove_count = commit % 10 == 9 ? 1500 : static_cast<int>(generator() % 60);
+        for (int i = 0; i < remove_count && !live_ids.empty(); ++i) {
+            const size_t position = generator() % live_ids.size();
+            snapshot_server.RemoveDocument(live_ids[position]);
+            expected.RemoveDocument(live_ids[position]);
+            live_ids[position] = live_ids.back();
+            live_ids.pop_back();
+        }
+        // Removing an unknown document does nothing
+        snapshot_server.RemoveDocument(-1);
+        snapshot_server.Commit();
+
+        const auto snapshot = snapshot_server.GetSnapshot();
+        const string hint = "commit "s + to_string(commit);
+        ASSERT_EQUAL_HINT(snapshot_server.GetGeneration(), static_cast<uint64_t>(commit + 1), hint);
+        AssertSameAsServer(*snapshot, expected, hint);
+        max_segment_count = max(max_segment_count, snapshot->GetSegmentCount());
+    }
+    // About 12k documents were added, yet tiered merging keeps the segments few
+    ASSERT(max_segment_count > 1);
+    ASSERT(max_segment_count < 12);
+}
+
+TEST_CASE(TestSnapshotMatchDocument) {
+    SnapshotSearchServer snapshot_server("and with"s);
+    for (int id = 0; id < 3000; ++id) {
+        snapshot_server.AddDocument(id, "cat w"s + to_string(id % 7), static_cast<DocumentStatus>(id % 4), { 1 });
+    }
+    snapshot_server.Commit();
+    // A document removed from a sealed segment and added again lives in the open one
+    snapshot_server.RemoveDocument(10);
+    snapshot_server.RemoveDocument(11);
+    snapshot_server.Commit();
+    snapshot_server.AddDocument(10, "dog"s, DocumentStatus::BANNED, { 2 });
+    snapshot_server.Commit();
+
+    const auto snapshot = snapshot_server.GetSnapshot();
+    // The matched words are views of the query
+    const string query = "cat dog w3"s;
+    const auto [words, status] = snapshot->MatchDocument(query, 10);
+    ASSERT_EQUAL(words.size(), 1u);
+    ASSERT_EQUAL(words[0], "dog"sv);
+    ASSERT(status == DocumentStatus::BANNED);
+    ASSERT(get<0>(snapshot->MatchDocument("cat"s, 11)).empty());
+    const string sealed_query = "cat w3 -dog"s;
+    const auto [sealed_words, sealed_status] = snapshot->MatchDocument(sealed_query, 38);
+    ASSERT_EQUAL(sealed_words.size(), 2u);
+    ASSERT(sealed_status == DocumentStatus::BANNED);
+}
+
+TEST_CASE(TestSnapshotsStayUnchanged) {
+    SnapshotSearchServer snapshot_server("and with"s);
+    const auto empty = snapshot_server.GetSnapshot();
+    snapshot_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+    snapshot_server.AddDocument(2, "black cat"s, DocumentStatus::ACTUAL, { 2 });
+    // Staged changes are not visible before the commit
+    ASSERT_EQUAL(snapshot_server.GetSnapshot()->GetDocumentCount(), 0);
+    snapshot_server.Commit();
+    const auto first = snapshot_server.GetSnapshot();
+    snapshot_server.RemoveDocument(1);
+    snapshot_server.Commit();
+
+    ASSERT(empty->FindTopDocuments("cat"s).empty());
+    ASSERT_EQUAL(first->FindTopDocuments("cat"s).size(), 2u);
+    ASSERT_EQUAL(snapshot_server.GetSnapshot()->FindTopDocuments("cat"s).size(), 1u);
+    ASSERT_EQUAL(snapshot_server.GetGeneration(), 2u);
+}
+
+TEST_CASE(TestSnapshotCommitRejectsInvalidChanges) {
+    SnapshotSearchServer snapshot_server("and with"s);
+    snapshot_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+    snapshot_server.Commit();
+    snapshot_server.AddDocument(2, "black cat"s, DocumentStatus::ACTUAL, { 2 });
+    snapshot_server.AddDocument(1, "grey cat"s, DocumentStatus::ACTUAL, { 3 });
+    bool is_thrown = false;
+    try {
+        snapshot_server.Commit();
+    }
+    catch (const invalid_argument&) {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    // Nothing was published and the staged changes were dropped
+    ASSERT_EQUAL(snapshot_server.GetGeneration(), 1u);
+    snapshot_server.Commit();
+    ASSERT_EQUAL(snapshot_server.GetGeneration(), 1u);
+    ASSERT_EQUAL(snapshot_server.GetSnapshot()->GetDocumentCount(), 1);
+}
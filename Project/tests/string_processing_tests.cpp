@@ -0,0 +1,104 @@
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "string_processing.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    // Split at every space with find, then a per-character validity scan; the tokenizer before vectorization
+    bool SplitIntoValidWordsByFind(string_view text, vector<string_view>& words) {
+        words.clear();
+        while (true) {
+            const size_t space = text.find(' ');
+            words.push_back(text.substr(0, space));
+            if (space == text.npos) {
+                break;
+            }
+            text.remove_prefix(space + 1);
+        }
+        bool is_valid = true;
+        for (const string_view word : words) {
+            is_valid &= IsValidWord(word);
+        }
+        return is_valid;
+    }
+
+    // The words must be the same views of the text, not only equal strings
+    void AssertSplitLikeScalar(const string& text, vector<string_view>& words) {
+        vector<string_view> expected;
+        const bool expected_is_valid = SplitIntoValidWordsByFind(text, expected);
+        const bool is_valid = SplitIntoValidWords(text, words);
+        string hint = "text of "s + to_string(text.size()) + " bytes:"s;
+        for (const char c : text) {
+            hint += " "s + to_string(static_cast<unsigned char>(c));
+        }
+        ASSERT_EQUAL_HINT(is_valid, expected_is_valid, hint);
+        ASSERT_EQUAL_HINT(words.size(), expected.size(), hint);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQUAL_HINT(words[i].data() - text.data(), expected[i].data() - text.data(), hint);
+            ASSERT_EQUAL_HINT(words[i].size(), expected[i].size(), hint);
+        }
+    }
+
+    // Lengths around the 16- and 32-byte blocks and their multiples
+    const vector<size_t> BLOCK_EDGE_LENGTHS = { 0, 1, 15, 16, 17, 31, 32, 33, 47, 48, 63, 64, 65, 95, 96, 97 };
+
+}
+
+TEST_CASE(TestSplitIntoValidWordsSpacesAtBlockEdges) {
+    vector<string_view> words;
+    for (const size_t length : BLOCK_EDGE_LENGTHS) {
+        // Words that cross the block edges, then a single space at every position
+        AssertSplitLikeScalar(string(length, 'w'), words);
+        for (size_t pos = 0; pos < length; ++pos) {
+            string text(length, 'w');
+            text[pos] = ' ';
+            AssertSplitLikeScalar(text, words);
+        }
+        // Leading, trailing and repeated spaces give empty words
+        AssertSplitLikeScalar(string(length, ' '), words);
+        for (size_t pos = 0; pos + 1 < length; ++pos) {
+            string text(length, 'w');
+            text[0] = text[pos] = text[pos + 1] = text[length - 1] = ' ';
+            AssertSplitLikeScalar(text, words);
+        }
+    }
+}
+
+TEST_CASE(TestSplitIntoValidWordsControlCharactersAtBlockEdges) {
+    vector<string_view> words;
+    // The lowest and highest control characters; DEL and bytes above 127 are not control characters
+    for (const char c : { '\0', '\x01', '\x1f', '\x7f', '\x80', '\xff' }) {
+        for (const size_t length : BLOCK_EDGE_LENGTHS) {
+            for (size_t pos = 0; pos < length; ++pos) {
+                string text(length, 'w');
+                for (size_t space = 5; space < length; space += 7) {
+                    text[space] = ' ';
+                }
+                text[pos] = c;
+                AssertSplitLikeScalar(text, words);
+            }
+        }
+    }
+}
+
+TEST_CASE(TestSplitIntoValidWordsMatchesScalarOnRandomText) {
+    const string alphabet = "ab- \t\n\x01\x1f\x7f\x80\xff"s + '\0';
+    mt19937 generator(15);
+    // The buffer is reused across calls, as by the servers
+    vector<string_view> words;
+    for (int i = 0; i < 20'000; ++i) {
+        string text(generator() % 200, 'a');
+        // Mostly letters and spaces, so that most texts are valid
+        for (char& c : text) {
+            const unsigned kind = generator() % 16;
+            c = kind < 10 ? 'a' + kind : kind < 13 ? ' ' : alphabet[generator() % alphabet.size()];
+        }
+        AssertSplitLikeScalar(text, words);
+    }
+}
@@ -0,0 +1,197 @@
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "term_dictionary.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace {
+
+    // Every term of the model has its id in the dictionary, and every id maps back to its term
+    void AssertSameTerms(const TermDictionary& terms, const map<string, TermId>& expected, const string& hint) {
+        ASSERT_EQUAL_HINT(terms.size(), expected.size(), hint);
+        for (const auto& [term, term_id] : expected) {
+            ASSERT_EQUAL_HINT(terms.Find(term), term_id, hint + ", "s + term);
+            ASSERT_EQUAL_HINT(terms.GetTerm(term_id), term, hint);
+        }
+    }
+
+    // Terms long enough that a few thousand of them pass the compaction threshold
+    string MakeTerm(int number) {
+        return "term-"s + string(number % 7 * 5, 'x') + to_string(number);
+    }
+
+}
+
+TEST_CASE(TestStringArenaKeepsStoredStrings) {
+    StringArena arena(16);
+    vector<string> texts;
+    vector<string_view> stored;
+    // Strings shorter than a block share it, a longer one gets a block of its own
+    for (const size_t size : { 0, 5, 10, 16, 40, 3, 15 }) {
+        texts.push_back(string(size, static_cast<char>('a' + texts.size())));
+        stored.push_back(arena.Store(texts.back()));
+    }
+    for (size_t i = 0; i < texts.size(); ++i) {
+        ASSERT_EQUAL(stored[i], texts[i]);
+        ASSERT(stored[i].data() != texts[i].data() || texts[i].empty());
+    }
+    ASSERT(arena.GetMemoryUsage() >= 16 * 4 + 40);
+}
+
+TEST_CASE(TestTermDictionaryInternsAndFinds) {
+    TermDictionary terms;
+    ASSERT_EQUAL(terms.Find("cat"s), TermDictionary::NO_TERM);
+    ASSERT_EQUAL(terms.Intern("cat"s), 0u);
+    ASSERT_EQUAL(terms.Intern("dog"s), 1u);
+    ASSERT_EQUAL(terms.Intern(""s), 2u);
+    ASSERT_EQUAL(terms.Intern("cat"s), 0u);
+    ASSERT_EQUAL(terms.size(), 3u);
+    ASSERT_EQUAL(terms.GetIdLimit(), 3u);
+    ASSERT_EQUAL(terms.Find(""s), 2u);
+    ASSERT_EQUAL(terms.Find("ca"s), TermDictionary::NO_TERM);
+
+    // The dictionary keeps its own bytes, not the caller's
+    string term = "bird"s;
+    const TermId term_id = terms.Intern(term);
+    term[0] = 'w';
+    ASSERT_EQUAL(terms.GetTerm(term_id), "bird"sv);
+    ASSERT_EQUAL(terms.Find("word"s), TermDictionary::NO_TERM);
+}
+
+TEST_CASE(TestTermDictionaryReusesErasedIdsAndBytes) {
+    TermDictionary terms;
+    const TermId cat = terms.Intern("cat"s);
+    const TermId dog = terms.Intern("dog"s);
+    const char* const cat_bytes = terms.GetTerm(cat).data();
+
+    terms.Erase(cat);
+    ASSERT_EQUAL(terms.Find("cat"s), TermDictionary::NO_TERM);
+    ASSERT_EQUAL(terms.size(), 1u);
+    ASSERT_EQUAL(terms.GetDeadBytes(), 3u);
+
+    // A new term takes the free id and new bytes
+    const TermId bird = terms.Intern("bird"s);
+    ASSERT_EQUAL(bird, cat);
+    ASSERT_EQUAL(terms.GetTerm(bird), "bird"sv);
+    ASSERT(terms.GetTerm(bird).data() != cat_bytes);
+    ASSERT_EQUAL(terms.GetDeadBytes(), 3u);
+
+    // The erased term interned again takes back its bytes, under a new id
+    const TermId cat_again = terms.Intern("cat"s);
+    ASSERT_EQUAL(cat_again, 2u);
+    ASSERT_EQUAL(terms.GetTerm(cat_again).data(), cat_bytes);
+    ASSERT_EQUAL(terms.GetDeadBytes(), 0u);
+    ASSERT_EQUAL(terms.GetTerm(dog), "dog"sv);
+    ASSERT_EQUAL(terms.GetIdLimit(), 3u);
+}
+
+TEST_CASE(TestTermDictionaryCompactsKeepingIds) {
+    static constexpr int TERM_COUNT = 10'000;
+    TermDictionary terms;
+    map<string, TermId> expected;
+    for (int i = 0; i < TERM_COUNT; ++i) {
+        expected[MakeTerm(i)] = terms.Intern(MakeTerm(i));
+    }
+    const size_t memory_usage = terms.GetMemoryUsage();
+
+    // Erasing nine terms in ten makes the dead bytes outgrow the live ones and the threshold
+    bool is_compacted = false;
+    for (int i = 0; i < TERM_COUNT; ++i) {
+        if (i % 10 == 0) {
+            continue;
+        }
+        const size_t dead_bytes = terms.GetDeadBytes();
+        terms.Erase(expected.at(MakeTerm(i)));
+        expected.erase(MakeTerm(i));
+        if (terms.GetDeadBytes() < dead_bytes) {
+            ASSERT_EQUAL(terms.GetDeadBytes(), 0u);
+            ASSERT(dead_bytes + MakeTerm(i).size() > 64 * 1024);
+            is_compacted = true;
+            AssertSameTerms(terms, expected, "compacted after "s + to_string(i));
+        }
+    }
+    ASSERT(is_compacted);
+    AssertSameTerms(terms, expected, "erased"s);
+    ASSERT(terms.GetMemoryUsage() < memory_usage);
+
+    // The ids of the erased terms are still handed out
+    const TermId term_id = terms.Intern(MakeTerm(1));
+    ASSERT(term_id < TERM_COUNT);
+    ASSERT(expected.count(MakeTerm(1)) == 0);
+    ASSERT_EQUAL(terms.GetTerm(term_id), MakeTerm(1));
+    ASSERT_EQUAL(terms.GetIdLimit(), static_cast<size_t>(TERM_COUNT));
+}
+
+TEST_CASE(TestTermDictionaryCopyOwnsItsTerms) {
+    map<string, TermId> expected;
+    TermDictionary copy;
+    {
+        TermDictionary terms;
+        for (int i = 0; i < 1000; ++i) {
+            expected[MakeTerm(i)] = terms.Intern(MakeTerm(i));
+        }
+        for (int i = 0; i < 1000; i += 3) {
+            terms.Erase(expected.at(MakeTerm(i)));
+            expected.erase(MakeTerm(i));
+        }
+        copy = terms;
+        const TermDictionary constructed(terms);
+        for (const TermDictionary* duplicate : vector<const TermDictionary*>{ &copy, &constructed }) {
+            AssertSameTerms(*duplicate, expected, "copy"s);
+            ASSERT_EQUAL(duplicate->GetIdLimit(), terms.GetIdLimit());
+            ASSERT_EQUAL(duplicate->GetDeadBytes(), 0u);
+            for (const auto& [term, term_id] : expected) {
+                ASSERT(duplicate->GetTerm(term_id).data() != terms.GetTerm(term_id).data());
+            }
+        }
+        // Changes of the original do not reach the copy
+        terms.Intern("fresh"s);
+        terms.Erase(expected.at(MakeTerm(1)));
+    }
+    // The original and its arena are gone
+    AssertSameTerms(copy, expected, "copy of a destroyed dictionary"s);
+    // The copy hands out the free ids of the original
+    ASSERT(copy.Intern("fresh"s) % 3 == 0);
+    ASSERT_EQUAL(copy.GetIdLimit(), 1000u);
+}
+
+TEST_CASE(TestTermDictionaryMatchesModel) {
+    TermDictionary terms;
+    map<string, TermId> expected;
+    set<TermId> free_ids;
+    mt19937 generator(7);
+    for (int step = 0; step < 200'000; ++step) {
+        const string term = MakeTerm(generator() % 20'000);
+        const auto it = expected.find(term);
+        if (it != expected.end() && generator() % 2 == 0) {
+            terms.Erase(it->second);
+            free_ids.insert(it->second);
+            expected.erase(it);
+            continue;
+        }
+        const size_t id_limit = terms.GetIdLimit();
+        const TermId term_id = terms.Intern(term);
+        if (it != expected.end()) {
+            ASSERT_EQUAL(term_id, it->second);
+            continue;
+        }
+        // New terms take a free id while there is one
+        if (free_ids.empty()) {
+            ASSERT_EQUAL(term_id, id_limit);
+        }
+        else {
+            ASSERT(free_ids.erase(term_id) == 1);
+        }
+        expected[term] = term_id;
+        if (step % 20'000 == 0) {
+            AssertSameTerms(terms, expected, "step "s + to_string(step));
+        }
+    }
+    AssertSameTerms(terms, expected, "end"s);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Minimal test runner. A TEST_CASE registers itself, RunTests runs all registered cases
+// and reports each one. A failed assertion throws, so the other cases still run
+
+struct TestCase {
+    const char* name;
+    void (*function)();
+};
+
+inline std::vector<TestCase>& GetTestCases() {
+    static std::vector<TestCase> test_cases;
+    return test_cases;
+}
+
+struct TestCaseRegistrar {
+    TestCaseRegistrar(const char* name, void (*function)()) {
+        GetTestCases().push_back({ name, function });
+    }
+};
+
+#define TEST_CASE(name)                                                        \
+    static void name();                                                        \
+    static const TestCaseRegistrar name##_registrar(#name, name);              \
+    static void name()
+
+class AssertionFailure : public std::logic_error {
+public:
+    using std::logic_error::logic_error;
+};
+
+template <typename T, typename U>
+void AssertEqualImpl(const T& t, const U& u, const std::string& t_str, const std::string& u_str, const std::string& file,
+    const std::string& func, unsigned line, const std::string& hint) {
+    using namespace std::literals;
+
+    if (!(t == u)) {
+        std::ostringstream message;
+        message << file << "("s << line << "): "s << func << ": "s
+            << "ASSERT_EQUAL("s << t_str << ", "s << u_str << ") failed: "s << t << " != "s << u << "."s;
+        if (!hint.empty()) {
+            message << " Hint: "s << hint;
+        }
+        throw AssertionFailure(message.str());
+    }
+}
+
+inline void AssertImpl(bool value, const std::string& expr_str, const std::string& file, const std::string& func, unsigned line,
+    const std::string& hint) {
+    using namespace std::literals;
+
+    if (!value) {
+        std::ostringstream message;
+        message << file << "("s << line << "): "s << func << ": "s << "ASSERT("s << expr_str << ") failed."s;
+        if (!hint.empty()) {
+            message << " Hint: "s << hint;
+        }
+        throw AssertionFailure(message.str());
+    }
+}
+
+#define ASSERT_EQUAL(a, b) AssertEqualImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, std::string())
+
+#define ASSERT_EQUAL_HINT(a, b, hint) AssertEqualImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, (hint))
+
+#define ASSERT(expr) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, std::string())
+
+#define ASSERT_HINT(expr, hint) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, (hint))
+
+// Returns the number of failed cases
+inline int RunTests() {
+    using namespace std::literals;
+
+    int failed_count = 0;
+    for (const auto& [name, function] : GetTestCases()) {
+        try {
+            function();
+            std::cerr << name << " OK"s << std::endl;
+        }
+        catch (const std::exception& e) {
+            ++failed_count;
+            std::cerr << name << " failed: "s << e.what() << std::endl;
+        }
+    }
+    if (failed_count > 0) {
+        std::cerr << failed_count << " of "s << GetTestCases().size() << " test cases failed"s << std::endl;
+    }
+    return failed_count;
+}
@@ -0,0 +1,5 @@
+#include "test_framework.h"
+
+int main() {
+    return RunTests() == 0 ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test_framework.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace {
+
+    // Long enough for any stolen task to run, short enough that a broken pool fails instead of hanging
+    const auto WAIT_TIMEOUT = chrono::seconds(30);
+
+    // Spins until the count reaches the target or the timeout runs out; returns whether it did
+    bool WaitForCount(const atomic<size_t>& count, size_t target) {
+        const auto deadline = chrono::steady_clock::now() + WAIT_TIMEOUT;
+        while (count < target) {
+            if (chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            this_thread::yield();
+        }
+        return true;
+    }
+
+    void AssertEveryIndexOnce(const vector<atomic<int>>& calls, const string& hint) {
+        for (size_t i = 0; i < calls.size(); ++i) {
+            ASSERT_EQUAL_HINT(calls[i].load(), 1, hint + ", index "s + to_string(i));
+        }
+    }
+
+}
+
+// Submit used to publish a task before counting it, so a worker could pop it first and wrap the
+// pending count around to SIZE_MAX. The count is watched while threads outside the pool submit,
+// by a thread of its own and by every task, which starts right after its worker took the count down
+TEST_CASE(TestThreadPoolPendingCountStaysInRange) {
+    static constexpr size_t SUBMITTER_COUNT = 4;
+    static constexpr size_t TASKS_PER_SUBMITTER = 20'000;
+    static constexpr size_t TASK_COUNT = SUBMITTER_COUNT * TASKS_PER_SUBMITTER;
+    ThreadPool pool(3);
+    atomic<size_t> done_count = 0;
+    atomic<size_t> max_pending_count = 0;
+    atomic<bool> is_submitting = true;
+
+    const auto watch = [&pool, &max_pending_count] {
+        const size_t pending_count = pool.GetPendingTaskCount();
+        size_t max_count = max_pending_count;
+        while (pending_count > max_count && !max_pending_count.compare_exchange_weak(max_count, pending_count)) {
+        }
+    };
+    thread watcher([&] {
+        while (is_submitting) {
+            watch();
+        }
+        });
+    vector<thread> submitters;
+    for (size_t t = 0; t < SUBMITTER_COUNT; ++t) {
+        submitters.emplace_back([&pool, &done_count, &watch] {
+            for (size_t i = 0; i < TASKS_PER_SUBMITTER; ++i) {
+                pool.Submit([&done_count, &watch] {
+                    watch();
+                    ++done_count;
+                    });
+            }
+            });
+    }
+    for (thread& submitter : submitters) {
+        submitter.join();
+    }
+    ASSERT(WaitForCount(done_count, TASK_COUNT));
+    is_submitting = false;
+    watcher.join();
+
+    ASSERT(max_pending_count <= TASK_COUNT);
+    ASSERT_EQUAL(pool.GetPendingTaskCount(), 0u);
+    ASSERT_EQUAL(done_count.load(), TASK_COUNT);
+}
+
+// Tasks submitted by a worker go to its own deque. The worker then waits for them, so they
+// only run if another worker steals them
+TEST_CASE(TestThreadPoolStealsTasks) {
+    static constexpr size_t TASK_COUNT = 50;
+    ThreadPool pool(2);
+    atomic<size_t> done_count = 0;
+    atomic<size_t> stolen_count = 0;
+    mutex result_mutex;
+    condition_variable result_ready;
+    bool is_finished = false;
+    bool is_stolen = false;
+
+    pool.Submit([&] {
+        const thread::id spawner = this_thread::get_id();
+        for (size_t i = 0; i < TASK_COUNT; ++i) {
+            pool.Submit([&done_count, &stolen_count, spawner] {
+                stolen_count += this_thread::get_id() != spawner;
+                ++done_count;
+                });
+        }
+        const bool all_done = WaitForCount(done_count, TASK_COUNT);
+        lock_guard guard(result_mutex);
+        is_stolen = all_done;
+        is_finished = true;
+        result_ready.notify_one();
+        });
+
+    unique_lock lock(result_mutex);
+    result_ready.wait(lock, [&is_finished] {
+        return is_finished;
+        });
+    ASSERT(is_stolen);
+    ASSERT_EQUAL(stolen_count.load(), TASK_COUNT);
+}
+
+TEST_CASE(TestParallelForRunsEveryIndexOnce) {
+    ThreadPool pool(4);
+    // No index, fewer indices than workers, and many more
+    for (const size_t count : { 0, 1, 3, 4, 5, 1000 }) {
+        vector<atomic<int>> calls(count);
+        pool.ParallelFor(count, [&calls](size_t i) {
+            ++calls[i];
+            });
+        AssertEveryIndexOnce(calls, "count "s + to_string(count));
+    }
+}
+
+// The only worker is blocked, so the calling thread has to run every index itself
+TEST_CASE(TestParallelForCallerParticipates) {
+    ThreadPool pool(1);
+    mutex block_mutex;
+    condition_variable unblocked;
+    bool is_blocked = true;
+    pool.Submit([&] {
+        unique_lock lock(block_mutex);
+        unblocked.wait(lock, [&is_blocked] {
+            return !is_blocked;
+            });
+        });
+
+    vector<atomic<int>> calls(100);
+    pool.ParallelFor(calls.size(), [&calls](size_t i) {
+        ++calls[i];
+        });
+    AssertEveryIndexOnce(calls, "blocked worker"s);
+
+    {
+        lock_guard guard(block_mutex);
+        is_blocked = false;
+    }
+    unblocked.notify_one();
+}
+
+// Every outer call waits for an inner ParallelFor while holding a worker, and there are more
+// outer calls than workers; waiting threads run pending indices instead of blocking
+TEST_CASE(TestNestedParallelForRunsEveryIndexOnce) {
+    static constexpr size_t OUTER_COUNT = 16;
+    static constexpr size_t INNER_COUNT = 64;
+    for (const size_t thread_count : { 1, 2, 3 }) {
+        ThreadPool pool(thread_count);
+        vector<atomic<int>> calls(OUTER_COUNT * INNER_COUNT);
+        pool.ParallelFor(OUTER_COUNT, [&pool, &calls](size_t outer) {
+            pool.ParallelFor(INNER_COUNT, [&calls, outer](size_t inner) {
+                ++calls[outer * INNER_COUNT + inner];
+                });
+            });
+        AssertEveryIndexOnce(calls, to_string(thread_count) + " threads"s);
+    }
+}
+
+TEST_CASE(TestParallelForRethrows) {
+    ThreadPool pool(2);
+    vector<atomic<int>> calls(200);
+    bool is_thrown = false;
+    try {
+        pool.ParallelFor(calls.size(), [&calls](size_t i) {
+            ++calls[i];
+            if (i % 50 == 7) {
+                throw runtime_error("index "s + to_string(i));
+            }
+            });
+    }
+    catch (const runtime_error&) {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    // The other calls still ran before ParallelFor returned
+    AssertEveryIndexOnce(calls, "throwing"s);
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <execution>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+#include "top_documents.h"
+
+using namespace std;
+
+namespace {
+
+    const vector<size_t> MAX_COUNTS = { 0, 1, 2, 5, 7, 100, 100'000 };
+
+    // Relevances in groups 0.01 apart, jittered by less than 1e-7 within a group, so that documents of a
+    // group tie on relevance and the order of the rest is fixed
+    vector<Document> MakeDocuments(unsigned seed, int document_count) {
+        mt19937 generator(seed);
+        vector<Document> documents;
+        for (int id = 0; id < document_count; ++id) {
+            const double relevance = 0.01 * (generator() % 10) + 1e-8 * (generator() % 10);
+            documents.push_back({ id, relevance, static_cast<int>(generator() % 4) });
+        }
+        shuffle(documents.begin(), documents.end(), generator);
+        return documents;
+    }
+
+    // The first max_count documents of the full result, or all of them
+    vector<Document> Prefix(const vector<Document>& documents, size_t max_count) {
+        return { documents.begin(), documents.begin() + min(max_count, documents.size()) };
+    }
+
+}
+
+TEST_CASE(TestTopDocumentsKeepsBestOfEveryCount) {
+    const vector<Document> documents = MakeDocuments(2, 500);
+    vector<Document> sorted = documents;
+    sort(sorted.begin(), sorted.end(), TopDocuments::IsBetter);
+
+    TopDocuments reused(0);
+    for (const size_t max_count : MAX_COUNTS) {
+        TopDocuments top_documents(max_count);
+        reused.Reset(max_count);
+        for (const Document& document : documents) {
+            top_documents.Push(document);
+            reused.Push(document);
+        }
+        ASSERT_EQUAL(top_documents.IsFull(), max_count <= documents.size());
+        const string hint = "max_count "s + to_string(max_count);
+        AssertSameDocuments(top_documents.Extract(), Prefix(sorted, max_count), hint);
+        vector<Document> result;
+        reused.ExtractTo(result);
+        AssertSameDocuments(result, Prefix(sorted, max_count), hint + ", reused"s);
+    }
+}
+
+TEST_CASE(TestTopDocumentsBreaksTiesWithinEpsilon) {
+    // Relevances closer than 1e-6 tie, and the higher rating wins
+    ASSERT(TopDocuments::IsBetter({ 1, 1.0, 5 }, { 2, 1.0 + 0.9e-6, 4 }));
+    ASSERT(!TopDocuments::IsBetter({ 2, 1.0 + 0.9e-6, 4 }, { 1, 1.0, 5 }));
+    // Farther apart, the relevance decides
+    ASSERT(TopDocuments::IsBetter({ 2, 1.0 + 1.1e-6, 4 }, { 1, 1.0, 5 }));
+    ASSERT(!TopDocuments::IsBetter({ 1, 1.0, 5 }, { 2, 1.0 + 1.1e-6, 4 }));
+    // A full tie goes to the smaller id
+    ASSERT(TopDocuments::IsBetter({ 3, 1.0, 5 }, { 4, 1.0 + 0.5e-6, 5 }));
+    ASSERT(!TopDocuments::IsBetter({ 4, 1.0 + 0.5e-6, 5 }, { 3, 1.0, 5 }));
+
+    // A tied document enters a full collector only by rating or id. The relevances are all within 1e-6
+    // of each other, so every pair ties
+    TopDocuments top_documents(2);
+    for (const Document& document : vector<Document>{ { 5, 2.0, 1 }, { 6, 2.0 + 0.3e-6, 1 }, { 7, 2.0 - 0.3e-6, 1 }, { 2, 2.0, 0 } }) {
+        top_documents.Push(document);
+    }
+    AssertSameDocuments(top_documents.Extract(), { { 5, 2.0, 1 }, { 6, 2.0 + 0.3e-6, 1 } });
+    top_documents.Reset(2);
+    for (const Document& document : vector<Document>{ { 5, 2.0, 1 }, { 6, 2.0 + 0.3e-6, 1 }, { 7, 2.0 - 0.3e-6, 2 }, { 1, 2.0, 1 } }) {
+        top_documents.Push(document);
+    }
+    AssertSameDocuments(top_documents.Extract(), { { 7, 2.0 - 0.3e-6, 2 }, { 1, 2.0, 1 } });
+}
+
+// Every overload taking a count returns the first max_count documents of the unbounded result
+TEST_CASE(TestFindTopDocumentsTakesCountPerCall) {
+    // Large enough for the parallel policy to split the search into parts
+    const SearchServer search_server = MakeRandomSearchServer(2, 20'000, 40, 9);
+    const auto is_actual = [](int document_id, DocumentStatus status, int rating) {
+        return status == DocumentStatus::ACTUAL;
+    };
+    SearchServer::QueryContext context;
+    for (const string& query : { "w0"s, "w1 w2 w3 -w4"s, "w30 w39"s, "unknown"s }) {
+        const vector<Document> all = search_server.FindTopDocuments(execution::seq, query, is_actual, 1'000'000);
+        ASSERT_HINT(query == "unknown"s || all.size() > 100, query);
+        const SearchServer::PreparedQuery prepared = search_server.Prepare(query);
+        for (const size_t max_count : MAX_COUNTS) {
+            const vector<Document> expected = Prefix(all, max_count);
+            const string hint = query + ", max_count "s + to_string(max_count);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::seq, query, is_actual, max_count), expected, hint);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, is_actual, max_count), expected, hint + ", par"s);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, max_count), expected, hint + ", status"s);
+            AssertSameDocuments(search_server.FindTopDocuments(context, query, is_actual, max_count), expected, hint + ", context"s);
+            AssertSameDocuments(search_server.FindTopDocuments(execution::par, prepared, is_actual, max_count), expected, hint + ", prepared"s);
+        }
+    }
+}
+
+// Documents of equal relevance come by rating, then by id, and the count cuts through the ties
+TEST_CASE(TestFindTopDocumentsCutsThroughTies) {
+    SearchServer search_server("and"s);
+    const vector<int> ratings = { 3, 5, 3, 5, 1, 3 };
+    for (int id = 0; id < static_cast<int>(ratings.size()); ++id) {
+        search_server.AddDocument(10 - id, "cat and dog"s, DocumentStatus::ACTUAL, { ratings[id] });
+    }
+    search_server.AddDocument(20, "bird"s, DocumentStatus::ACTUAL, { 9 });
+    const vector<int> expected_ids = { 7, 9, 5, 8, 10, 6 };
+    for (const size_t max_count : MAX_COUNTS) {
+        const vector<Document> documents = search_server.FindTopDocuments(execution::seq, "cat"s, DocumentStatus::ACTUAL, max_count);
+        ASSERT_EQUAL(documents.size(), min(max_count, expected_ids.size()));
+        for (size_t i = 0; i < documents.size(); ++i) {
+            ASSERT_EQUAL_HINT(documents[i].id, expected_ids[i], to_string(max_count));
+        }
+    }
+}
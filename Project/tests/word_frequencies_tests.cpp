@@ -0,0 +1,54 @@
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "search_server.h"
+#include "search_server_fixtures.h"
+#include "test_framework.h"
+
+using namespace std;
+
+TEST_CASE(TestWordFrequenciesOfUnknownAndEmptyDocuments) {
+    SearchServer search_server = MakeExampleSearchServer();
+    search_server.AddDocument(6, "and with and"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.RemoveDocument(2);
+
+    // Unknown, removed and stop-word-only documents all have no words
+    for (const int document_id : { -1, 0, 2, 6, 100 }) {
+        const WordFrequencies word_freqs = search_server.GetWordFrequencies(document_id);
+        ASSERT_HINT(word_freqs.empty(), to_string(document_id));
+        ASSERT_EQUAL_HINT(word_freqs.size(), 0u, to_string(document_id));
+        ASSERT_HINT(word_freqs.begin() == word_freqs.end(), to_string(document_id));
+    }
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 5);
+
+    const vector<pair<string_view, double>> expected = { { "cat"sv, 0.25 }, { "collar"sv, 0.25 }, { "fashionable"sv, 0.25 }, { "white"sv, 0.25 } };
+    const WordFrequencies word_freqs = search_server.GetWordFrequencies(1);
+    ASSERT_EQUAL(word_freqs.size(), expected.size());
+    ASSERT(equal(word_freqs.begin(), word_freqs.end(), expected.begin(), expected.end()));
+}
+
+// Added documents neither move the forward index entry of a document nor the bytes of its words
+TEST_CASE(TestWordFrequenciesSurviveAddedDocuments) {
+    SearchServer search_server = MakeExampleSearchServer();
+    const WordFrequencies word_freqs = search_server.GetWordFrequencies(5);
+    vector<string_view> words;
+    for (const auto& [word, term_freq] : word_freqs) {
+        words.push_back(word);
+    }
+
+    for (int id = 10; id < 5000; ++id) {
+        search_server.AddDocument(id, "cat w"s + to_string(id) + " tail x"s + to_string(id % 97), DocumentStatus::ACTUAL, { 1 });
+    }
+    ASSERT_EQUAL(words.size(), 5u);
+    size_t i = 0;
+    for (const auto& [word, term_freq] : word_freqs) {
+        ASSERT_EQUAL(word, words[i]);
+        ASSERT_EQUAL(word.data(), words[i].data());
+        ++i;
+    }
+    ASSERT_EQUAL(string(words[0]), "cat"s);
+    ASSERT_EQUAL(string(words[4]), "tail"s);
+}
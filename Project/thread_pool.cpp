@@ -0,0 +1,122 @@
+#include "thread_pool.h"
+
+namespace {
+    // Pool and worker index of the calling thread, if it is a worker
+    thread_local const ThreadPool* current_pool = nullptr;
+    thread_local size_t current_worker = 0;
+}
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_[i]->thread = std::thread([this, i] {
+            WorkerLoop(i);
+            });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard guard(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_up_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+void ThreadPool::Submit(Task task) {
+    // A worker keeps the tasks it spawns local; other threads spread theirs round-robin
+    const size_t index = (current_pool == this)
+        ? current_worker
+        : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    // Counted before it is published, so a worker that pops it never takes the count below zero
+    {
+        std::lock_guard guard(sleep_mutex_);
+        ++pending_count_;
+    }
+    {
+        std::lock_guard guard(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+    wake_up_.notify_one();
+}
+
+ThreadPool& ThreadPool::GetDefault() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+    current_pool = this;
+    current_worker = index;
+    while (true) {
+        Task task;
+        if (TryPop(index, task)) {
+            --pending_count_;
+            task();
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex_);
+        wake_up_.wait(lock, [this] {
+            return stopping_ || pending_count_ > 0;
+            });
+        if (stopping_ && pending_count_ == 0) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::TryPop(size_t index, Task& task) {
+    {
+        Worker& own = *workers_[index];
+        std::lock_guard guard(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        Worker& victim = *workers_[(index + i) % workers_.size()];
+        std::lock_guard guard(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::ParallelForState::Run() {
+    for (size_t i = next_index.fetch_add(1); i < count; i = next_index.fetch_add(1)) {
+        try {
+            (*body)(i);
+        }
+        catch (...) {
+            std::lock_guard guard(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        if (done_count.fetch_add(1) + 1 == count) {
+            std::lock_guard guard(mutex);
+            all_done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::ParallelForState::Wait() {
+    std::unique_lock lock(mutex);
+    all_done.wait(lock, [this] {
+        return done_count == count;
+        });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque. A worker takes the newest
+// task of its own deque and, when that is empty, steals the oldest task of another worker
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(size_t thread_count = std::max(1u, std::thread::hardware_concurrency()));
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    size_t GetThreadCount() const {
+        return workers_.size();
+    }
+
+    // Tasks submitted and not started yet; never more than were submitted
+    size_t GetPendingTaskCount() const {
+        return pending_count_;
+    }
+
+    void Submit(Task task);
+
+    // Calls function(i) for every i in [0, count) and returns when all calls are done.
+    // The calling thread takes part and never waits for a call that has not started yet,
+    // so ParallelFor may be nested inside tasks of the same pool without deadlocks.
+    // The first exception thrown by function is rethrown in the calling thread
+    template <typename Function>
+    void ParallelFor(size_t count, Function function) {
+        if (count == 0) {
+            return;
+        }
+        auto state = std::make_shared<ParallelForState>(count);
+        const std::function<void(size_t)> body = function;
+        state->body = &body;
+
+        const size_t helper_count = std::min(count - 1, GetThreadCount());
+        for (size_t i = 0; i < helper_count; ++i) {
+            Submit([state] {
+                state->Run();
+            });
+        }
+        state->Run();
+        state->Wait();
+    }
+
+    // Pool shared by all users that do not bring their own
+    static ThreadPool& GetDefault();
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    struct ParallelForState {
+        explicit ParallelForState(size_t count)
+            : count(count) {
+        }
+
+        void Run();
+        void Wait();
+
+        const size_t count;
+        const std::function<void(size_t)>* body = nullptr;
+        std::atomic<size_t> next_index = 0;
+        std::atomic<size_t> done_count = 0;
+        std::mutex mutex;
+        std::condition_variable all_done;
+        std::exception_ptr error;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_worker_ = 0;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_up_;
+    // Tasks submitted and not popped yet; a task is counted before it becomes visible to TryPop
+    std::atomic<size_t> pending_count_ = 0;
+    bool stopping_ = false;
+
+    void WorkerLoop(size_t index);
+
+    bool TryPop(size_t index, Task& task);
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "document.h"
+
+// Keeps the best max_count documents seen so far in a bounded heap, so selecting
+// the top of n matches costs O(n log max_count) instead of sorting all of them
+class TopDocuments {
+public:
+
+    explicit TopDocuments(size_t max_count)
+        : max_count_(max_count) {
+        documents_.reserve(max_count_);
+    }
+
+    // Relevance first, rating breaks ties between relevances closer than 1e-6,
+    // and the smaller id wins a full tie so the order does not depend on the input order
+    static bool IsBetter(const Document& lhs, const Document& rhs) {
+        if (std::abs(lhs.relevance - rhs.relevance) >= 1e-6) {
+            return lhs.relevance > rhs.relevance;
+        }
+        if (lhs.rating != rhs.rating) {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.id < rhs.id;
+    }
+
+    size_t GetMaxCount() const {
+        return max_count_;
+    }
+
+    bool IsFull() const {
+        return documents_.size() == max_count_;
+    }
+
+    // Worst of the kept documents; the collector must not be empty
+    const Document& GetWorst() const {
+        return documents_.front();
+    }
+
+    void Push(const Document& document) {
+        if (documents_.size() < max_count_) {
+            documents_.push_back(document);
+            std::push_heap(documents_.begin(), documents_.end(), IsBetter);
+        }
+        else if (max_count_ > 0 && IsBetter(document, documents_.front())) {
+            std::pop_heap(documents_.begin(), documents_.end(), IsBetter);
+            documents_.back() = document;
+            std::push_heap(documents_.begin(), documents_.end(), IsBetter);
+        }
+    }
+
+    // Drops the kept documents and sets a new bound; the memory is kept for reuse
+    void Reset(size_t max_count) {
+        max_count_ = max_count;
+        documents_.clear();
+        documents_.reserve(max_count_);
+    }
+
+    // Same as Extract, into a vector whose memory is reused
+    void ExtractTo(std::vector<Document>& result) {
+        std::sort_heap(documents_.begin(), documents_.end(), IsBetter);
+        result.assign(documents_.begin(), documents_.end());
+        documents_.clear();
+    }
+
+    // Best document first; the collector is left empty
+    std::vector<Document> Extract() {
+        std::sort_heap(documents_.begin(), documents_.end(), IsBetter);
+        std::vector<Document> result = std::move(documents_);
+        documents_.clear();
+        return result;
+    }
+
+private:
+    size_t max_count_;
+    // Heap ordered by IsBetter: the worst kept document is at the front
+    std::vector<Document> documents_;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "term_dictionary.h"
+
+// Read-only view of the forward index entry of one document.
+// Iterates over (word, term frequency) pairs in word order without copying anything.
+// The words view the term dictionary, so they follow its rules: see SearchServer::GetWordFrequencies
+class WordFrequencies {
+public:
+    using Entry = std::pair<TermId, double>;
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(const TermDictionary* terms, std::vector<Entry>::const_iterator entry)
+            : terms_(terms)
+            , entry_(entry) {
+        }
+
+        value_type operator*() const {
+            return { terms_->GetTerm(entry_->first), entry_->second };
+        }
+
+        Iterator& operator++() {
+            ++entry_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++entry_;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return entry_ == other.entry_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return entry_ != other.entry_;
+        }
+
+    private:
+        const TermDictionary* terms_;
+        std::vector<Entry>::const_iterator entry_;
+    };
+
+    WordFrequencies(const TermDictionary& terms, const std::vector<Entry>& entries)
+        : terms_(&terms)
+        , entries_(&entries) {
+    }
+
+    Iterator begin() const {
+        return { terms_, entries_->begin() };
+    }
+
+    Iterator end() const {
+        return { terms_, entries_->end() };
+    }
+
+    size_t size() const {
+        return entries_->size();
+    }
+
+    bool empty() const {
+        return entries_->empty();
+    }
+
+private:
+    const TermDictionary* terms_;
+    const std::vector<Entry>* entries_;
+};